@@ -9,6 +9,7 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -346,6 +347,7 @@ ide_read (void *d_, block_sector_t sec_no, void *buffer)
 {
   struct ata_disk *d = d_;
   struct channel *c = d->channel;
+  trace (TRACE_DISK_READ, TRACE_BEGIN, sec_no, 0);
   lock_acquire (&c->lock);
   select_sector (d, sec_no);
   issue_pio_command (c, CMD_READ_SECTOR_RETRY);
@@ -354,6 +356,7 @@ ide_read (void *d_, block_sector_t sec_no, void *buffer)
     PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
   input_sector (c, buffer);
   lock_release (&c->lock);
+  trace (TRACE_DISK_READ, TRACE_END, sec_no, 0);
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -366,6 +369,7 @@ ide_write (void *d_, block_sector_t sec_no, const void *buffer)
 {
   struct ata_disk *d = d_;
   struct channel *c = d->channel;
+  trace (TRACE_DISK_WRITE, TRACE_BEGIN, sec_no, 0);
   lock_acquire (&c->lock);
   select_sector (d, sec_no);
   issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
@@ -374,6 +378,7 @@ ide_write (void *d_, block_sector_t sec_no, const void *buffer)
   output_sector (c, buffer);
   sema_down (&c->completion_wait);
   lock_release (&c->lock);
+  trace (TRACE_DISK_WRITE, TRACE_END, sec_no, 0);
 }
 
 static struct block_operations ide_operations =
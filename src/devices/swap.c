@@ -1,6 +1,7 @@
 #include "devices/swap.h"
 #include "devices/block.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include <bitmap.h>
 #include <debug.h>
@@ -53,8 +54,10 @@ swap_out (const void *vaddr)
   size_t sector = slot * PAGE_SECTORS;
   
   // loop over each sector of the page, copying it from memory into swap
+  trace (TRACE_SWAP_OUT, TRACE_BEGIN, (uintptr_t) vaddr, slot);
   for (size_t i = 0; i < PAGE_SECTORS; i++)
     block_write (swap_device, sector + i, vaddr + i * BLOCK_SECTOR_SIZE);
+  trace (TRACE_SWAP_OUT, TRACE_END, (uintptr_t) vaddr, slot);
 
   return slot;
 }
@@ -67,8 +70,10 @@ swap_in (void *vaddr, size_t slot)
   size_t sector = slot * PAGE_SECTORS;
 
   // loop over each sector of the page, copying it from swap into memory
+  trace (TRACE_SWAP_IN, TRACE_BEGIN, (uintptr_t) vaddr, slot);
   for (size_t i = 0; i < PAGE_SECTORS; i++)
     block_read (swap_device, sector + i, vaddr + i * BLOCK_SECTOR_SIZE);
+  trace (TRACE_SWAP_IN, TRACE_END, (uintptr_t) vaddr, slot);
   
   // clear the swap-slot previously used by this page
   swap_drop (slot);
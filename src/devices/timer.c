@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include "devices/pit.h"
 #include "threads/interrupt.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 #include <string.h>
@@ -35,6 +36,11 @@ static struct list wakeup_info;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Function called on every timer interrupt, or null, and its
+   auxiliary data.  See timer_set_tick_hook(). */
+static timer_tick_hook_func *tick_hook;
+static void *tick_hook_aux;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
@@ -202,6 +208,19 @@ timer_ndelay (int64_t ns)
   real_time_delay (ns, 1000 * 1000 * 1000);
 }
 
+/* Arranges for HOOK to be called with AUX from the timer
+   interrupt handler on every tick, replacing any hook set
+   before.  A null HOOK removes the hook.  HOOK runs in interrupt
+   context, so it must not sleep. */
+void
+timer_set_tick_hook (timer_tick_hook_func *hook, void *aux)
+{
+  enum intr_level old_level = intr_disable ();
+  tick_hook = hook;
+  tick_hook_aux = aux;
+  intr_set_level (old_level);
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void)
@@ -244,9 +263,10 @@ calc_set_recent_cpu_action (struct thread *t, void *aux UNUSED)
 
 /* Timer interrupt handler. */
 static void
-timer_interrupt (struct intr_frame *args UNUSED)
+timer_interrupt (struct intr_frame *args)
 {
   ticks++;
+  profile_sample (args);
   /* Disabling interrupts like this is unnecessary as interrupts are already
       turned off when running an interrupt handler. */
   enum intr_level old_level = intr_disable();
@@ -299,6 +319,8 @@ timer_interrupt (struct intr_frame *args UNUSED)
         }
     }
   intr_set_level (old_level);
+  if (tick_hook != NULL)
+    tick_hook (tick_hook_aux);
   thread_tick ();
 }
 
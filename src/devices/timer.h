@@ -27,6 +27,10 @@ void timer_mdelay (int64_t milliseconds);
 void timer_udelay (int64_t microseconds);
 void timer_ndelay (int64_t nanoseconds);
 
+/* Function called from the timer interrupt handler. */
+typedef void timer_tick_hook_func (void *aux);
+void timer_set_tick_hook (timer_tick_hook_func *, void *aux);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
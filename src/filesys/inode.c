@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -57,11 +58,15 @@ byte_to_sector (const struct inode *inode, off_t pos)
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Cache that struct inodes come from. */
+static struct kmem_cache inode_cache;
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  kmem_cache_init (&inode_cache, "inode", sizeof (struct inode), NULL);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -127,7 +132,7 @@ inode_open (block_sector_t sector)
     }
 
   /* Allocate memory. */
-  inode = malloc (sizeof *inode);
+  inode = kmem_cache_alloc (&inode_cache);
   if (inode == NULL)
     return NULL;
 
@@ -181,7 +186,7 @@ inode_close (struct inode *inode)
                             bytes_to_sectors (inode->data.length)); 
         }
 
-      free (inode); 
+      kmem_cache_free (&inode_cache, inode);
     }
 }
 
@@ -317,6 +322,81 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
   return bytes_written;
 }
 
+/* Copies SIZE bytes from SRC, starting at SRC_OFS, into DST,
+   starting at DST_OFS, a sector at a time, without passing the
+   data through a caller's buffer.  Where both offsets fall on
+   sector boundaries, each whole sector read from SRC is written
+   to DST as is.  The two ranges must not overlap if SRC and DST
+   are the same inode.  Returns the number of bytes actually
+   copied, which may be less than SIZE if end of either file is
+   reached or an error occurs. */
+off_t
+inode_copy (struct inode *dst, off_t dst_ofs,
+            struct inode *src, off_t src_ofs, off_t size)
+{
+  off_t bytes_copied = 0;
+  uint8_t *buf;
+
+  if (dst->deny_write_cnt)
+    return 0;
+
+  /* One sector for SRC, one for DST when it needs merging. */
+  buf = malloc (2 * BLOCK_SECTOR_SIZE);
+  if (buf == NULL)
+    return 0;
+
+  while (size > 0)
+    {
+      /* Sectors to copy between, starting byte offsets within them. */
+      block_sector_t src_idx = byte_to_sector (src, src_ofs);
+      block_sector_t dst_idx = byte_to_sector (dst, dst_ofs);
+      int src_sector_ofs = src_ofs % BLOCK_SECTOR_SIZE;
+      int dst_sector_ofs = dst_ofs % BLOCK_SECTOR_SIZE;
+
+      /* Bytes left in either inode or sector, least of the four. */
+      off_t src_left = inode_length (src) - src_ofs;
+      off_t dst_left = inode_length (dst) - dst_ofs;
+      int src_sector_left = BLOCK_SECTOR_SIZE - src_sector_ofs;
+      int dst_sector_left = BLOCK_SECTOR_SIZE - dst_sector_ofs;
+      off_t chunk_size = size;
+      if (chunk_size > src_left)
+        chunk_size = src_left;
+      if (chunk_size > dst_left)
+        chunk_size = dst_left;
+      if (chunk_size > src_sector_left)
+        chunk_size = src_sector_left;
+      if (chunk_size > dst_sector_left)
+        chunk_size = dst_sector_left;
+      if (chunk_size <= 0)
+        break;
+
+      block_read (fs_device, src_idx, buf);
+      if (dst_sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
+        {
+          /* Whole sector to whole sector. */
+          block_write (fs_device, dst_idx, buf);
+        }
+      else
+        {
+          /* Merge the chunk into DST's sector, which the chunk
+             never covers whole here. */
+          uint8_t *merge = buf + BLOCK_SECTOR_SIZE;
+          block_read (fs_device, dst_idx, merge);
+          memcpy (merge + dst_sector_ofs, buf + src_sector_ofs, chunk_size);
+          block_write (fs_device, dst_idx, merge);
+        }
+
+      /* Advance. */
+      size -= chunk_size;
+      src_ofs += chunk_size;
+      dst_ofs += chunk_size;
+      bytes_copied += chunk_size;
+    }
+  free (buf);
+
+  return bytes_copied;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 void
@@ -3,6 +3,7 @@
 #include <limits.h>
 #include <round.h>
 #include <stdio.h>
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
 #ifdef FILESYS
 #include "filesys/file.h"
@@ -21,13 +22,26 @@ typedef unsigned long elem_type;
 /* Number of bits in an element. */
 #define ELEM_BITS (sizeof (elem_type) * CHAR_BIT)
 
+/* Bitmaps with at least this many bits also keep a summary
+   level, described below. */
+#define SUMMARY_MIN_BITS 8192
+
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   A large bitmap also has a summary level, `full', with one bit
+   per element of `bits' that is set exactly when every bit of
+   that element is set.  bitmap_scan() uses it to skip 32
+   elements at a time when looking for a false bit in a mostly
+   full bitmap, such as the free map of a big disk.  Each change
+   to an element and its summary bit is made with interrupts
+   disabled, so that single-bit updates stay atomic. */
 struct bitmap
   {
     size_t bit_cnt;     /* Number of bits. */
     elem_type *bits;    /* Elements that represent bits. */
+    elem_type *full;    /* Summary of `bits', or null if none. */
   };
 
 /* Returns the index of the element that contains the bit
@@ -69,6 +83,163 @@ last_mask (const struct bitmap *b)
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
 
+/* Returns the number of summary elements for a bitmap of
+   BIT_CNT bits, which is 0 if it has no summary. */
+static inline size_t
+summary_elem_cnt (size_t bit_cnt) 
+{
+  return bit_cnt >= SUMMARY_MIN_BITS ? elem_cnt (elem_cnt (bit_cnt)) : 0;
+}
+
+/* Returns the number of bytes required for BIT_CNT bits and
+   their summary. */
+static inline size_t
+storage_byte_cnt (size_t bit_cnt) 
+{
+  return byte_cnt (bit_cnt) + sizeof (elem_type) * summary_elem_cnt (bit_cnt);
+}
+
+/* Returns the bits of element ELEM_IDX of B that lie within the
+   bit range [START, END). */
+static inline elem_type
+range_mask (size_t elem_idx, size_t start, size_t end) 
+{
+  size_t first = elem_idx * ELEM_BITS;
+  elem_type mask = (elem_type) -1;
+
+  if (start > first)
+    mask &= (elem_type) -1 << (start - first);
+  if (end < first + ELEM_BITS)
+    mask &= ((elem_type) 1 << (end - first)) - 1;
+  return mask;
+}
+
+/* Returns element ELEM_IDX of B with each bit set to VALUE
+   turned on and every other bit, including unused bits past
+   the end of B, turned off. */
+static inline elem_type
+match_elem (const struct bitmap *b, size_t elem_idx, bool value) 
+{
+  elem_type bits = b->bits[elem_idx];
+
+  if (!value)
+    bits = ~bits;
+  if (elem_idx == elem_cnt (b->bit_cnt) - 1)
+    bits &= last_mask (b);
+  return bits;
+}
+
+/* Returns the index of the lowest bit set in BITS, which must be
+   nonzero. */
+static inline size_t
+first_set (elem_type bits) 
+{
+  elem_type idx;
+  asm ("bsfl %1, %0" : "=r" (idx) : "rm" (bits) : "cc");
+  return idx;
+}
+
+/* Returns the number of bits set in BITS. */
+static inline size_t
+count_set (elem_type bits) 
+{
+  bits = bits - ((bits >> 1) & 0x55555555);
+  bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+  bits = (bits + (bits >> 4)) & 0x0f0f0f0f;
+  return (bits * 0x01010101) >> 24;
+}
+
+/* Brings the summary bit for element ELEM_IDX of B up to date.
+   B must have a summary. */
+static void
+update_summary (struct bitmap *b, size_t elem_idx) 
+{
+  if (match_elem (b, elem_idx, false) == 0)
+    b->full[elem_idx / ELEM_BITS] |= bit_mask (elem_idx);
+  else
+    b->full[elem_idx / ELEM_BITS] &= ~bit_mask (elem_idx);
+}
+
+/* Atomically sets the bits in MASK within element ELEM_IDX of B
+   to VALUE, keeping the summary, if any, in step. */
+static void
+set_elem_bits (struct bitmap *b, size_t elem_idx, elem_type mask, bool value) 
+{
+  enum intr_level old_level = INTR_ON;
+
+  if (b->full != NULL)
+    old_level = intr_disable ();
+
+  /* These are equivalent to `b->bits[elem_idx] |= mask' and
+     `b->bits[elem_idx] &= ~mask' except that they are guaranteed
+     to be atomic on a uniprocessor machine.  See the
+     descriptions of the OR and AND instructions in [IA32-v2b]
+     and [IA32-v2a]. */
+  if (value)
+    asm ("orl %1, %0" : "=m" (b->bits[elem_idx]) : "r" (mask) : "cc");
+  else
+    asm ("andl %1, %0" : "=m" (b->bits[elem_idx]) : "r" (~mask) : "cc");
+
+  if (b->full != NULL)
+    {
+      update_summary (b, elem_idx);
+      intr_set_level (old_level);
+    }
+}
+
+/* Returns the index of the first element of B at or after
+   ELEM_IDX that is not entirely set, according to B's summary,
+   or elem_cnt(B->bit_cnt) if there is none. */
+static size_t
+next_nonfull_elem (const struct bitmap *b, size_t elem_idx) 
+{
+  size_t summary_idx = elem_idx / ELEM_BITS;
+  size_t summary_cnt = summary_elem_cnt (b->bit_cnt);
+  size_t last = elem_cnt (b->bit_cnt);
+  elem_type nonfull;
+
+  if (elem_idx >= last)
+    return last;
+
+  nonfull = ~b->full[summary_idx] & ((elem_type) -1 << (elem_idx % ELEM_BITS));
+  while (nonfull == 0)
+    {
+      if (++summary_idx >= summary_cnt)
+        return last;
+      nonfull = ~b->full[summary_idx];
+    }
+
+  elem_idx = summary_idx * ELEM_BITS + first_set (nonfull);
+  return elem_idx < last ? elem_idx : last;
+}
+
+/* Returns the index of the first bit in B at or after START that
+   is set to VALUE, or B's size if there is none. */
+static size_t
+find_next (const struct bitmap *b, size_t start, bool value) 
+{
+  size_t last = elem_cnt (b->bit_cnt);
+  size_t idx;
+  elem_type bits;
+
+  if (start >= b->bit_cnt)
+    return b->bit_cnt;
+
+  idx = elem_idx (start);
+  bits = match_elem (b, idx, value) & ((elem_type) -1 << (start % ELEM_BITS));
+  while (bits == 0)
+    {
+      if (!value && b->full != NULL)
+        idx = next_nonfull_elem (b, idx + 1);
+      else
+        idx++;
+      if (idx >= last)
+        return b->bit_cnt;
+      bits = match_elem (b, idx, value);
+    }
+  return idx * ELEM_BITS + first_set (bits);
+}
+
 /* Creation and destruction. */
 
 /* Initializes B to be a bitmap of BIT_CNT bits
@@ -82,9 +253,11 @@ bitmap_create (size_t bit_cnt)
   if (b != NULL)
     {
       b->bit_cnt = bit_cnt;
-      b->bits = malloc (byte_cnt (bit_cnt));
+      b->bits = malloc (storage_byte_cnt (bit_cnt));
       if (b->bits != NULL || bit_cnt == 0)
         {
+          b->full = (summary_elem_cnt (bit_cnt) > 0
+                     ? b->bits + elem_cnt (bit_cnt) : NULL);
           bitmap_set_all (b, false);
           return b;
         }
@@ -105,6 +278,8 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type *) (b + 1);
+  b->full = (summary_elem_cnt (bit_cnt) > 0
+             ? b->bits + elem_cnt (bit_cnt) : NULL);
   bitmap_set_all (b, false);
   return b;
 }
@@ -114,7 +289,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 size_t
 bitmap_buf_size (size_t bit_cnt) 
 {
-  return sizeof (struct bitmap) + byte_cnt (bit_cnt);
+  return sizeof (struct bitmap) + storage_byte_cnt (bit_cnt);
 }
 
 /* Destroys bitmap B, freeing its storage.
@@ -157,26 +332,14 @@ bitmap_set (struct bitmap *b, size_t idx, bool value)
 void
 bitmap_mark (struct bitmap *b, size_t bit_idx) 
 {
-  size_t idx = elem_idx (bit_idx);
-  elem_type mask = bit_mask (bit_idx);
-
-  /* This is equivalent to `b->bits[idx] |= mask' except that it
-     is guaranteed to be atomic on a uniprocessor machine.  See
-     the description of the OR instruction in [IA32-v2b]. */
-  asm ("orl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  set_elem_bits (b, elem_idx (bit_idx), bit_mask (bit_idx), true);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
 void
 bitmap_reset (struct bitmap *b, size_t bit_idx) 
 {
-  size_t idx = elem_idx (bit_idx);
-  elem_type mask = bit_mask (bit_idx);
-
-  /* This is equivalent to `b->bits[idx] &= ~mask' except that it
-     is guaranteed to be atomic on a uniprocessor machine.  See
-     the description of the AND instruction in [IA32-v2a]. */
-  asm ("andl %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+  set_elem_bits (b, elem_idx (bit_idx), bit_mask (bit_idx), false);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -187,11 +350,21 @@ bitmap_flip (struct bitmap *b, size_t bit_idx)
 {
   size_t idx = elem_idx (bit_idx);
   elem_type mask = bit_mask (bit_idx);
+  enum intr_level old_level = INTR_ON;
+
+  if (b->full != NULL)
+    old_level = intr_disable ();
 
   /* This is equivalent to `b->bits[idx] ^= mask' except that it
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the XOR instruction in [IA32-v2b]. */
   asm ("xorl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+
+  if (b->full != NULL)
+    {
+      update_summary (b, idx);
+      intr_set_level (old_level);
+    }
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -214,18 +387,23 @@ bitmap_set_all (struct bitmap *b, bool value)
   bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically, but the range as a whole
+   is not. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
+  size_t end = start + cnt;
   size_t i;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  if (cnt == 0)
+    return;
+  for (i = elem_idx (start); i <= elem_idx (end - 1); i++)
+    set_elem_bits (b, i, range_mask (i, start, end), value);
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -233,6 +411,7 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
+  size_t end = start + cnt;
   size_t i, value_cnt;
 
   ASSERT (b != NULL);
@@ -240,9 +419,10 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (start + cnt <= b->bit_cnt);
 
   value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
+  if (cnt > 0)
+    for (i = elem_idx (start); i <= elem_idx (end - 1); i++)
+      value_cnt += count_set (match_elem (b, i, value)
+                              & range_mask (i, start, end));
   return value_cnt;
 }
 
@@ -251,15 +431,17 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
+  size_t end = start + cnt;
   size_t i;
   
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
+  if (cnt > 0)
+    for (i = elem_idx (start); i <= elem_idx (end - 1); i++)
+      if ((match_elem (b, i, value) & range_mask (i, start, end)) != 0)
+        return true;
   return false;
 }
 
@@ -296,18 +478,30 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt)
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
+  size_t i = start;
+
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
-  if (cnt <= b->bit_cnt) 
+  if (cnt > b->bit_cnt || start > b->bit_cnt - cnt)
+    return BITMAP_ERROR;
+  if (cnt == 0)
+    return start;
+
+  /* Jump from each run of bits set to VALUE to the next, a whole
+     element at a time, until one is long enough. */
+  for (;;)
     {
-      size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
+      size_t run_end;
+
+      i = find_next (b, i, value);
+      if (i >= b->bit_cnt || cnt > b->bit_cnt - i)
+        return BITMAP_ERROR;
+      run_end = find_next (b, i, !value);
+      if (run_end - i >= cnt)
+        return i;
+      i = run_end;
     }
-  return BITMAP_ERROR;
 }
 
 /* Finds the first group of CNT consecutive bits in B at or after
@@ -347,6 +541,12 @@ bitmap_read (struct bitmap *b, struct file *file)
       off_t size = byte_cnt (b->bit_cnt);
       success = file_read_at (file, b->bits, size, 0) == size;
       b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+      if (b->full != NULL) 
+        {
+          size_t i;
+          for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+            update_summary (b, i);
+        }
     }
   return success;
 }
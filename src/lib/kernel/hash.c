@@ -18,6 +18,39 @@ static struct hash_elem *find_elem (struct hash *, struct list *,
 static void insert_elem (struct hash *, struct list *, struct hash_elem *);
 static void remove_elem (struct hash *, struct hash_elem *);
 static void rehash (struct hash *);
+static bool start_rehash (struct hash *, size_t new_bucket_cnt);
+static void migrate_buckets (struct hash *, size_t cnt);
+static void finish_rehash (struct hash *);
+
+/* Returns X with its lowest-order bit set to 1 turned off. */
+static inline size_t
+turn_off_least_1bit (size_t x) 
+{
+  return x & (x - 1);
+}
+
+/* Returns true if X is a power of 2, otherwise false. */
+static inline size_t
+is_power_of_2 (size_t x) 
+{
+  return x != 0 && turn_off_least_1bit (x) == 0;
+}
+
+/* Returns the smallest power of 2 greater than or equal to X,
+   which must be nonzero. */
+static inline size_t
+round_up_to_power_of_2 (size_t x) 
+{
+  size_t p = x;
+  while (!is_power_of_2 (p))
+    p = turn_off_least_1bit (p);
+  return p < x ? p << 1 : p;
+}
+
+/* Element per bucket ratios. */
+#define MIN_ELEMS_PER_BUCKET  1 /* Elems/bucket < 1: reduce # of buckets. */
+#define BEST_ELEMS_PER_BUCKET 2 /* Ideal elems/bucket. */
+#define MAX_ELEMS_PER_BUCKET  4 /* Elems/bucket > 4: increase # of buckets. */
 
 /* Initializes hash table H to compute hash values using HASH and
    compare hash elements using LESS, given auxiliary data AUX. */
@@ -28,6 +61,10 @@ hash_init (struct hash *h,
   h->elem_cnt = 0;
   h->bucket_cnt = 4;
   h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
+  h->min_bucket_cnt = 4;
+  h->old_buckets = NULL;
+  h->old_bucket_cnt = 0;
+  h->migrate_idx = 0;
   h->hash = hash;
   h->less = less;
   h->aux = aux;
@@ -55,6 +92,7 @@ hash_clear (struct hash *h, hash_action_func *destructor)
 {
   size_t i;
 
+  finish_rehash (h);
   for (i = 0; i < h->bucket_cnt; i++) 
     {
       struct list *bucket = &h->buckets[i];
@@ -88,9 +126,38 @@ hash_destroy (struct hash *h, hash_action_func *destructor)
 {
   if (destructor != NULL)
     hash_clear (h, destructor);
+  free (h->old_buckets);
   free (h->buckets);
 }
 
+/* Sizes hash table H so that it can hold ELEM_CNT elements
+   without having to grow, and so that it does not shrink below
+   that size as elements are deleted.  Callers that know roughly
+   how many elements they are about to insert can use this to
+   avoid a series of resizes along the way.  Returns false if
+   memory for the larger table could not be allocated, in which
+   case H is unchanged and still usable. */
+bool
+hash_reserve (struct hash *h, size_t elem_cnt) 
+{
+  size_t bucket_cnt = elem_cnt / BEST_ELEMS_PER_BUCKET;
+
+  if (bucket_cnt < 4)
+    bucket_cnt = 4;
+  bucket_cnt = round_up_to_power_of_2 (bucket_cnt);
+
+  finish_rehash (h);
+  if (bucket_cnt > h->bucket_cnt)
+    {
+      if (!start_rehash (h, bucket_cnt))
+        return false;
+      finish_rehash (h);
+    }
+  if (bucket_cnt > h->min_bucket_cnt)
+    h->min_bucket_cnt = bucket_cnt;
+  return true;
+}
+
 /* Inserts NEW into hash table H and returns a null pointer, if
    no equal element is already in the table.
    If an equal element is already in the table, returns it
@@ -166,6 +233,7 @@ hash_apply (struct hash *h, hash_action_func *action)
   
   ASSERT (action != NULL);
 
+  finish_rehash (h);
   for (i = 0; i < h->bucket_cnt; i++) 
     {
       struct list *bucket = &h->buckets[i];
@@ -195,13 +263,16 @@ hash_apply (struct hash *h, hash_action_func *action)
    Modifying hash table H during iteration, using any of the
    functions hash_clear(), hash_destroy(), hash_insert(),
    hash_replace(), or hash_delete(), invalidates all
-   iterators. */
+   iterators.  hash_first() itself completes any resize in
+   progress, so it must not be called on a table that other
+   iterators are still using. */
 void
 hash_first (struct hash_iterator *i, struct hash *h) 
 {
   ASSERT (i != NULL);
   ASSERT (h != NULL);
 
+  finish_rehash (h);
   i->hash = h;
   i->bucket = i->hash->buckets;
   i->elem = list_elem_to_hash_elem (list_head (i->bucket));
@@ -308,12 +379,21 @@ hash_ptr (const void *p)
   return hash_bytes (&p, sizeof p);  
 }
 
-/* Returns the bucket in H that E belongs in. */
+/* Returns the bucket in H that E belongs in.  While H is being
+   resized, that is an old bucket if the old bucket has not been
+   migrated yet, and a new bucket otherwise. */
 static struct list *
 find_bucket (struct hash *h, struct hash_elem *e) 
 {
-  size_t bucket_idx = h->hash (e, h->aux) & (h->bucket_cnt - 1);
-  return &h->buckets[bucket_idx];
+  unsigned hash = h->hash (e, h->aux);
+
+  if (h->old_buckets != NULL) 
+    {
+      size_t old_idx = hash & (h->old_bucket_cnt - 1);
+      if (old_idx >= h->migrate_idx)
+        return &h->old_buckets[old_idx];
+    }
+  return &h->buckets[hash & (h->bucket_cnt - 1)];
 }
 
 /* Searches BUCKET in H for a hash element equal to E.  Returns
@@ -332,56 +412,71 @@ find_elem (struct hash *h, struct list *bucket, struct hash_elem *e)
   return NULL;
 }
 
-/* Returns X with its lowest-order bit set to 1 turned off. */
-static inline size_t
-turn_off_least_1bit (size_t x) 
-{
-  return x & (x - 1);
-}
-
-/* Returns true if X is a power of 2, otherwise false. */
-static inline size_t
-is_power_of_2 (size_t x) 
-{
-  return x != 0 && turn_off_least_1bit (x) == 0;
-}
-
-/* Element per bucket ratios. */
-#define MIN_ELEMS_PER_BUCKET  1 /* Elems/bucket < 1: reduce # of buckets. */
-#define BEST_ELEMS_PER_BUCKET 2 /* Ideal elems/bucket. */
-#define MAX_ELEMS_PER_BUCKET  4 /* Elems/bucket > 4: increase # of buckets. */
-
-/* Changes the number of buckets in hash table H to match the
-   ideal.  This function can fail because of an out-of-memory
-   condition, but that'll just make hash accesses less efficient;
-   we can still continue. */
+/* Number of old buckets migrated by each insertion or deletion
+   while a resize is in progress.  A resize to N buckets happens
+   only after the element count has moved by at least N/2 since
+   the previous one, so any value of 1 or more finishes each
+   migration well before the next resize is due. */
+#define MIGRATE_BUCKETS 2
+
+/* Advances any resize in progress in H, then starts a new one if
+   the number of elements per bucket has drifted outside
+   [MIN_ELEMS_PER_BUCKET, MAX_ELEMS_PER_BUCKET].  The new size
+   puts the table back at about BEST_ELEMS_PER_BUCKET, halfway
+   between the two limits, so that a few insertions and deletions
+   around a boundary cannot make it grow and shrink repeatedly.
+   This function can fail because of an out-of-memory condition,
+   but that'll just make hash accesses less efficient; we can
+   still continue. */
 static void
 rehash (struct hash *h) 
 {
-  size_t old_bucket_cnt, new_bucket_cnt;
-  struct list *new_buckets, *old_buckets;
-  size_t i;
+  size_t new_bucket_cnt;
 
   ASSERT (h != NULL);
 
-  /* Save old bucket info for later use. */
-  old_buckets = h->buckets;
-  old_bucket_cnt = h->bucket_cnt;
-
-  /* Calculate the number of buckets to use now.
-     We want one bucket for about every BEST_ELEMS_PER_BUCKET.
-     We must have at least four buckets, and the number of
-     buckets must be a power of 2. */
-  new_bucket_cnt = h->elem_cnt / BEST_ELEMS_PER_BUCKET;
-  if (new_bucket_cnt < 4)
-    new_bucket_cnt = 4;
-  while (!is_power_of_2 (new_bucket_cnt))
-    new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
-
-  /* Don't do anything if the bucket count wouldn't change. */
-  if (new_bucket_cnt == old_bucket_cnt)
+  migrate_buckets (h, MIGRATE_BUCKETS);
+
+  if (h->elem_cnt > h->bucket_cnt * MAX_ELEMS_PER_BUCKET) 
+    {
+      /* Grow, rounding down to a power of 2. */
+      new_bucket_cnt = h->elem_cnt / BEST_ELEMS_PER_BUCKET;
+      while (!is_power_of_2 (new_bucket_cnt))
+        new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
+    }
+  else if (h->elem_cnt < h->bucket_cnt * MIN_ELEMS_PER_BUCKET
+           && h->bucket_cnt > h->min_bucket_cnt) 
+    {
+      /* Shrink, rounding up to a power of 2, but no further
+         than the minimum. */
+      new_bucket_cnt = h->elem_cnt / BEST_ELEMS_PER_BUCKET;
+      if (new_bucket_cnt < h->min_bucket_cnt)
+        new_bucket_cnt = h->min_bucket_cnt;
+      new_bucket_cnt = round_up_to_power_of_2 (new_bucket_cnt);
+    }
+  else
     return;
 
+  if (new_bucket_cnt != h->bucket_cnt)
+    {
+      finish_rehash (h);
+      start_rehash (h, new_bucket_cnt);
+    }
+}
+
+/* Begins resizing H, which must not already be resizing, to
+   NEW_BUCKET_CNT buckets.  The current buckets become the old
+   array, whose elements migrate_buckets() moves over later.
+   Returns false if the new array cannot be allocated. */
+static bool
+start_rehash (struct hash *h, size_t new_bucket_cnt) 
+{
+  struct list *new_buckets;
+  size_t i;
+
+  ASSERT (h->old_buckets == NULL);
+  ASSERT (is_power_of_2 (new_bucket_cnt));
+
   /* Allocate new buckets and initialize them as empty. */
   new_buckets = malloc (sizeof *new_buckets * new_bucket_cnt);
   if (new_buckets == NULL) 
@@ -389,34 +484,57 @@ rehash (struct hash *h)
       /* Allocation failed.  This means that use of the hash table will
          be less efficient.  However, it is still usable, so
          there's no reason for it to be an error. */
-      return;
+      return false;
     }
   for (i = 0; i < new_bucket_cnt; i++) 
     list_init (&new_buckets[i]);
 
-  /* Install new bucket info. */
+  /* Install new bucket info, keeping the old buckets around
+     until their elements have all been moved. */
+  h->old_buckets = h->buckets;
+  h->old_bucket_cnt = h->bucket_cnt;
+  h->migrate_idx = 0;
   h->buckets = new_buckets;
   h->bucket_cnt = new_bucket_cnt;
+  return true;
+}
+
+/* Moves the elements of up to CNT old buckets in H into the
+   appropriate new buckets, freeing the old array once it is
+   empty.  Does nothing if H is not being resized. */
+static void
+migrate_buckets (struct hash *h, size_t cnt) 
+{
+  if (h->old_buckets == NULL)
+    return;
 
-  /* Move each old element into the appropriate new bucket. */
-  for (i = 0; i < old_bucket_cnt; i++) 
+  while (cnt-- > 0 && h->migrate_idx < h->old_bucket_cnt) 
     {
-      struct list *old_bucket;
-      struct list_elem *elem, *next;
+      struct list *old_bucket = &h->old_buckets[h->migrate_idx++];
 
-      old_bucket = &old_buckets[i];
-      for (elem = list_begin (old_bucket);
-           elem != list_end (old_bucket); elem = next) 
+      while (!list_empty (old_bucket)) 
         {
-          struct list *new_bucket
-            = find_bucket (h, list_elem_to_hash_elem (elem));
-          next = list_next (elem);
-          list_remove (elem);
-          list_push_front (new_bucket, elem);
+          struct list_elem *elem = list_pop_front (old_bucket);
+          struct hash_elem *e = list_elem_to_hash_elem (elem);
+          size_t idx = h->hash (e, h->aux) & (h->bucket_cnt - 1);
+          list_push_front (&h->buckets[idx], elem);
         }
     }
 
-  free (old_buckets);
+  if (h->migrate_idx >= h->old_bucket_cnt) 
+    {
+      free (h->old_buckets);
+      h->old_buckets = NULL;
+      h->old_bucket_cnt = 0;
+      h->migrate_idx = 0;
+    }
+}
+
+/* Completes any resize in progress in H. */
+static void
+finish_rehash (struct hash *h) 
+{
+  migrate_buckets (h, h->old_bucket_cnt);
 }
 
 /* Inserts E into BUCKET (in hash table H). */
@@ -55,12 +55,23 @@ typedef bool hash_less_func (const struct hash_elem *a,
    data AUX. */
 typedef void hash_action_func (struct hash_elem *e, void *aux);
 
-/* Hash table. */
+/* Hash table.
+
+   When the table is resized, its elements are moved from the old
+   bucket array to the new one a few buckets at a time, by each
+   later insertion or deletion, instead of all at once.  Until
+   then both arrays are in use: old buckets numbered below
+   `migrate_idx' have been emptied into the new array, and the
+   rest still hold their elements. */
 struct hash 
   {
     size_t elem_cnt;            /* Number of elements in table. */
     size_t bucket_cnt;          /* Number of buckets, a power of 2. */
     struct list *buckets;       /* Array of `bucket_cnt' lists. */
+    size_t min_bucket_cnt;      /* Never shrink below this many buckets. */
+    struct list *old_buckets;   /* Array being migrated, or null. */
+    size_t old_bucket_cnt;      /* Number of buckets in `old_buckets'. */
+    size_t migrate_idx;         /* Next old bucket to migrate. */
     hash_hash_func *hash;       /* Hash function. */
     hash_less_func *less;       /* Comparison function. */
     void *aux;                  /* Auxiliary data for `hash' and `less'. */
@@ -78,6 +89,7 @@ struct hash_iterator
 bool hash_init (struct hash *, hash_hash_func *, hash_less_func *, void *aux);
 void hash_clear (struct hash *, hash_action_func *);
 void hash_destroy (struct hash *, hash_action_func *);
+bool hash_reserve (struct hash *, size_t elem_cnt);
 
 /* Search, insertion, deletion. */
 struct hash_elem *hash_insert (struct hash *, struct hash_elem *);
@@ -0,0 +1,214 @@
+/* Integer-keyed map.
+
+   See intmap.h for basic information. */
+
+#include "intmap.h"
+#include "../debug.h"
+#include "threads/malloc.h"
+
+/* Number of slots allocated by the first insertion. */
+#define MIN_CAPACITY 8
+
+/* The map grows once more than MAX_LOAD_NUM / MAX_LOAD_DEN of its
+   slots would be in use.  Robin Hood probing keeps lookups short
+   up to a high load like this. */
+#define MAX_LOAD_NUM 7
+#define MAX_LOAD_DEN 8
+
+static size_t home_slot (const struct intmap *, int key);
+static size_t find_slot (const struct intmap *, int key);
+static void place (struct intmap *, int key, void *value);
+static bool grow (struct intmap *);
+
+/* Initializes MAP as an empty map.  No memory is allocated until
+   the first insertion. */
+void
+intmap_init (struct intmap *map)
+{
+  map->cnt = 0;
+  map->capacity = 0;
+  map->shift = 32;
+  map->slots = NULL;
+}
+
+/* Destroys MAP, freeing its slot array.
+
+   If ACTION is non-null, then it is first called for each entry
+   in the map, in arbitrary order.  ACTION may, if appropriate,
+   deallocate the memory used by the value.  However, modifying
+   MAP from ACTION yields undefined behavior. */
+void
+intmap_destroy (struct intmap *map, intmap_action_func *action)
+{
+  size_t i;
+
+  if (action != NULL)
+    for (i = 0; i < map->capacity; i++)
+      if (map->slots[i].dist != 0)
+        action (map->slots[i].key, map->slots[i].value);
+
+  free (map->slots);
+  intmap_init (map);
+}
+
+/* Adds KEY, which must not already be in MAP, with the given
+   non-null VALUE.  Returns true if successful, false if memory
+   for a larger slot array could not be allocated, in which case
+   MAP is unchanged. */
+bool
+intmap_insert (struct intmap *map, int key, void *value)
+{
+  ASSERT (value != NULL);
+
+  if ((map->cnt + 1) * MAX_LOAD_DEN > map->capacity * MAX_LOAD_NUM
+      && !grow (map))
+    return false;
+
+  place (map, key, value);
+  map->cnt++;
+  return true;
+}
+
+/* Returns the value associated with KEY in MAP, or a null
+   pointer if KEY is not in MAP. */
+void *
+intmap_find (const struct intmap *map, int key)
+{
+  size_t i = find_slot (map, key);
+  return i < map->capacity ? map->slots[i].value : NULL;
+}
+
+/* Removes KEY from MAP and returns its value, or returns a null
+   pointer if KEY was not in MAP. */
+void *
+intmap_remove (struct intmap *map, int key)
+{
+  size_t mask = map->capacity - 1;
+  size_t i = find_slot (map, key);
+  size_t next;
+  void *value;
+
+  if (i >= map->capacity)
+    return NULL;
+  value = map->slots[i].value;
+
+  /* Shift each following key that is away from its home slot
+     back by one, until reaching an empty slot or a key that is
+     already at home. */
+  for (next = (i + 1) & mask; map->slots[next].dist > 1;
+       next = (next + 1) & mask)
+    {
+      map->slots[i] = map->slots[next];
+      map->slots[i].dist--;
+      i = next;
+    }
+  map->slots[i].dist = 0;
+
+  map->cnt--;
+  return value;
+}
+
+/* Returns the number of keys in MAP. */
+size_t
+intmap_size (const struct intmap *map)
+{
+  return map->cnt;
+}
+
+/* Returns true if MAP contains no keys, false otherwise. */
+bool
+intmap_empty (const struct intmap *map)
+{
+  return map->cnt == 0;
+}
+
+/* Returns KEY's home slot in MAP, which must have a nonzero
+   capacity.  Multiplying by 2**32 divided by the golden ratio
+   spreads consecutive keys evenly over the table, and the top
+   bits of the product are the best mixed. */
+static size_t
+home_slot (const struct intmap *map, int key)
+{
+  return ((unsigned) key * 0x9e3779b9u) >> map->shift;
+}
+
+/* Returns the index of the slot holding KEY in MAP, or MAP's
+   capacity if KEY is not in MAP. */
+static size_t
+find_slot (const struct intmap *map, int key)
+{
+  size_t mask = map->capacity - 1;
+  unsigned dist;
+  size_t i;
+
+  if (map->cnt == 0)
+    return map->capacity;
+
+  /* Any slot holding KEY is at least as far from its home as
+     the slots before it, so the search can stop at the first
+     slot whose key is closer to home than KEY would be. */
+  for (i = home_slot (map, key), dist = 1; map->slots[i].dist >= dist;
+       i = (i + 1) & mask, dist++)
+    if (map->slots[i].key == key)
+      return i;
+  return map->capacity;
+}
+
+/* Stores KEY and VALUE in MAP, which must have a free slot,
+   without updating its count. */
+static void
+place (struct intmap *map, int key, void *value)
+{
+  size_t mask = map->capacity - 1;
+  struct intmap_slot entry;
+  size_t i;
+
+  entry.key = key;
+  entry.dist = 1;
+  entry.value = value;
+
+  for (i = home_slot (map, key); map->slots[i].dist != 0; i = (i + 1) & mask)
+    {
+      ASSERT (map->slots[i].key != entry.key);
+      if (map->slots[i].dist < entry.dist)
+        {
+          /* The key here is closer to its home than ours is:
+             take its slot and carry it further along. */
+          struct intmap_slot displaced = map->slots[i];
+          map->slots[i] = entry;
+          entry = displaced;
+        }
+      entry.dist++;
+    }
+  map->slots[i] = entry;
+}
+
+/* Doubles the capacity of MAP and reinserts its keys.  Returns
+   false if memory could not be allocated. */
+static bool
+grow (struct intmap *map)
+{
+  size_t old_capacity = map->capacity;
+  struct intmap_slot *old_slots = map->slots;
+  size_t new_capacity = old_capacity != 0 ? old_capacity * 2 : MIN_CAPACITY;
+  struct intmap_slot *new_slots;
+  size_t i;
+
+  new_slots = malloc (sizeof *new_slots * new_capacity);
+  if (new_slots == NULL)
+    return false;
+  for (i = 0; i < new_capacity; i++)
+    new_slots[i].dist = 0;
+
+  map->slots = new_slots;
+  map->capacity = new_capacity;
+  for (map->shift = 32; new_capacity > 1; new_capacity >>= 1)
+    map->shift--;
+
+  for (i = 0; i < old_capacity; i++)
+    if (old_slots[i].dist != 0)
+      place (map, old_slots[i].key, old_slots[i].value);
+
+  free (old_slots);
+  return true;
+}
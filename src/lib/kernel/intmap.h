@@ -0,0 +1,61 @@
+#ifndef __LIB_KERNEL_INTMAP_H
+#define __LIB_KERNEL_INTMAP_H
+
+/* Integer-keyed map.
+
+   Maps int keys to non-null pointer values using open addressing
+   with Robin Hood linear probing.  Keys and values are stored
+   inline in a single array of slots, so a lookup touches one or
+   two consecutive cache lines and compares keys directly, with
+   no per-element list nodes and no comparison callback.  This
+   makes it a better fit than struct hash for small tables keyed
+   by a descriptor number or thread id.
+
+   Robin Hood probing keeps the table sorted by each key's
+   distance from its home slot: an insertion that has probed
+   further than the key already in a slot takes that slot and
+   carries the displaced key onward.  Probe sequences therefore
+   stay short and uniform even at high load, and a lookup can stop
+   as soon as it reaches a key closer to home than the one it is
+   looking for.  Deletion shifts the following keys back by one
+   instead of leaving tombstones.
+
+   Unlike the list and hash table, the map owns its slot array,
+   which it allocates with malloc() on the first insertion and
+   doubles as needed. */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* One slot in the map. */
+struct intmap_slot
+  {
+    int key;                    /* Key. */
+    unsigned dist;              /* 1 + distance from home slot, 0 if empty. */
+    void *value;                /* Value. */
+  };
+
+/* Integer-keyed map. */
+struct intmap
+  {
+    size_t cnt;                 /* Number of keys in the map. */
+    size_t capacity;            /* Number of slots, a power of 2, or 0. */
+    unsigned shift;             /* 32 - log2(capacity). */
+    struct intmap_slot *slots;  /* Array of `capacity' slots. */
+  };
+
+/* Performs some operation on the entry with the given KEY and
+   VALUE. */
+typedef void intmap_action_func (int key, void *value);
+
+void intmap_init (struct intmap *);
+void intmap_destroy (struct intmap *, intmap_action_func *);
+
+bool intmap_insert (struct intmap *, int key, void *value);
+void *intmap_find (const struct intmap *, int key);
+void *intmap_remove (struct intmap *, int key);
+
+size_t intmap_size (const struct intmap *);
+bool intmap_empty (const struct intmap *);
+
+#endif /* lib/kernel/intmap.h */
@@ -0,0 +1,376 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* Our red-black trees follow the usual rules:
+
+     1. Every element is either red or black.
+     2. The root is black.
+     3. A red element never has a red child.
+     4. Every path from a given element down to a null child
+        passes through the same number of black elements.
+
+   Together these guarantee that the longest path from the root
+   is at most twice as long as the shortest, so the height of a
+   tree with n elements is O(log n).  Null children count as
+   black, which is why the code below checks for null before
+   looking at an element's color. */
+
+static void rotate_left (struct rb_tree *, struct rb_elem *);
+static void rotate_right (struct rb_tree *, struct rb_elem *);
+static void transplant (struct rb_tree *, struct rb_elem *old,
+                        struct rb_elem *new);
+static void insert_fixup (struct rb_tree *, struct rb_elem *);
+static void remove_fixup (struct rb_tree *, struct rb_elem *,
+                          struct rb_elem *parent);
+static struct rb_elem *leftmost (struct rb_elem *);
+static bool is_red (const struct rb_elem *);
+
+/* Initializes TREE as an empty tree ordered by LESS, given
+   auxiliary data AUX. */
+void
+rb_init (struct rb_tree *tree, rb_less_func *less, void *aux)
+{
+  ASSERT (tree != NULL);
+  ASSERT (less != NULL);
+
+  tree->root = NULL;
+  tree->min = NULL;
+  tree->size = 0;
+  tree->less = less;
+  tree->aux = aux;
+}
+
+/* Inserts ELEM into TREE.  ELEM is placed after any elements
+   already in TREE that compare equal to it. */
+void
+rb_insert (struct rb_tree *tree, struct rb_elem *elem)
+{
+  struct rb_elem *parent = NULL;
+  struct rb_elem **link = &tree->root;
+  bool leftmost_path = true;
+
+  ASSERT (elem != NULL);
+
+  while (*link != NULL)
+    {
+      parent = *link;
+      if (tree->less (elem, parent, tree->aux))
+        link = &parent->left;
+      else
+        {
+          link = &parent->right;
+          leftmost_path = false;
+        }
+    }
+
+  elem->parent = parent;
+  elem->left = elem->right = NULL;
+  elem->red = true;
+  *link = elem;
+
+  if (leftmost_path)
+    tree->min = elem;
+  tree->size++;
+
+  insert_fixup (tree, elem);
+}
+
+/* Removes ELEM, which must be in TREE, from TREE. */
+void
+rb_remove (struct rb_tree *tree, struct rb_elem *elem)
+{
+  struct rb_elem *child, *parent;
+  bool removed_red;
+
+  ASSERT (tree->size > 0);
+
+  if (tree->min == elem)
+    tree->min = rb_next (elem);
+
+  if (elem->left == NULL || elem->right == NULL)
+    {
+      /* ELEM has at most one child, which takes its place. */
+      child = elem->left != NULL ? elem->left : elem->right;
+      parent = elem->parent;
+      removed_red = elem->red;
+      transplant (tree, elem, child);
+    }
+  else
+    {
+      /* ELEM has two children.  Its in-order successor, which
+         has no left child, takes its place and color. */
+      struct rb_elem *succ = leftmost (elem->right);
+      removed_red = succ->red;
+      child = succ->right;
+      if (succ->parent == elem)
+        parent = succ;
+      else
+        {
+          parent = succ->parent;
+          transplant (tree, succ, succ->right);
+          succ->right = elem->right;
+          succ->right->parent = succ;
+        }
+      transplant (tree, elem, succ);
+      succ->left = elem->left;
+      succ->left->parent = succ;
+      succ->red = elem->red;
+    }
+
+  tree->size--;
+  if (!removed_red)
+    remove_fixup (tree, child, parent);
+}
+
+/* Removes and returns the smallest element in TREE, or returns
+   a null pointer if TREE is empty. */
+struct rb_elem *
+rb_pop_min (struct rb_tree *tree)
+{
+  struct rb_elem *min = tree->min;
+  if (min != NULL)
+    rb_remove (tree, min);
+  return min;
+}
+
+/* Returns the smallest element in TREE, or a null pointer if
+   TREE is empty. */
+struct rb_elem *
+rb_min (const struct rb_tree *tree)
+{
+  return tree->min;
+}
+
+/* Returns the element that follows ELEM in its tree's order, or
+   a null pointer if ELEM is the largest element. */
+struct rb_elem *
+rb_next (const struct rb_elem *elem)
+{
+  struct rb_elem *parent;
+
+  if (elem->right != NULL)
+    return leftmost (elem->right);
+
+  parent = elem->parent;
+  while (parent != NULL && elem == parent->right)
+    {
+      elem = parent;
+      parent = parent->parent;
+    }
+  return parent;
+}
+
+/* Returns the number of elements in TREE. */
+size_t
+rb_size (const struct rb_tree *tree)
+{
+  return tree->size;
+}
+
+/* Returns true if TREE contains no elements, false otherwise. */
+bool
+rb_empty (const struct rb_tree *tree)
+{
+  return tree->size == 0;
+}
+
+/* Restores the red-black properties after ELEM has been
+   inserted as a red leaf. */
+static void
+insert_fixup (struct rb_tree *tree, struct rb_elem *elem)
+{
+  struct rb_elem *parent;
+
+  while ((parent = elem->parent) != NULL && parent->red)
+    {
+      /* PARENT is red, so it is not the root. */
+      struct rb_elem *grandparent = parent->parent;
+
+      if (parent == grandparent->left)
+        {
+          struct rb_elem *uncle = grandparent->right;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              elem = grandparent;
+            }
+          else
+            {
+              if (elem == parent->right)
+                {
+                  elem = parent;
+                  rotate_left (tree, elem);
+                  parent = elem->parent;
+                }
+              parent->red = false;
+              grandparent->red = true;
+              rotate_right (tree, grandparent);
+            }
+        }
+      else
+        {
+          struct rb_elem *uncle = grandparent->left;
+          if (is_red (uncle))
+            {
+              parent->red = uncle->red = false;
+              grandparent->red = true;
+              elem = grandparent;
+            }
+          else
+            {
+              if (elem == parent->left)
+                {
+                  elem = parent;
+                  rotate_right (tree, elem);
+                  parent = elem->parent;
+                }
+              parent->red = false;
+              grandparent->red = true;
+              rotate_left (tree, grandparent);
+            }
+        }
+    }
+  tree->root->red = false;
+}
+
+/* Restores the red-black properties after a black element has
+   been removed from above ELEM, whose parent is now PARENT.
+   ELEM may be null, so PARENT is passed separately. */
+static void
+remove_fixup (struct rb_tree *tree, struct rb_elem *elem,
+              struct rb_elem *parent)
+{
+  while (elem != tree->root && !is_red (elem))
+    {
+      if (elem == parent->left)
+        {
+          struct rb_elem *sibling = parent->right;
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_left (tree, parent);
+              sibling = parent->right;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              elem = parent;
+              parent = elem->parent;
+            }
+          else
+            {
+              if (!is_red (sibling->right))
+                {
+                  sibling->left->red = false;
+                  sibling->red = true;
+                  rotate_right (tree, sibling);
+                  sibling = parent->right;
+                }
+              sibling->red = parent->red;
+              parent->red = false;
+              sibling->right->red = false;
+              rotate_left (tree, parent);
+              elem = tree->root;
+              break;
+            }
+        }
+      else
+        {
+          struct rb_elem *sibling = parent->left;
+          if (sibling->red)
+            {
+              sibling->red = false;
+              parent->red = true;
+              rotate_right (tree, parent);
+              sibling = parent->left;
+            }
+          if (!is_red (sibling->left) && !is_red (sibling->right))
+            {
+              sibling->red = true;
+              elem = parent;
+              parent = elem->parent;
+            }
+          else
+            {
+              if (!is_red (sibling->left))
+                {
+                  sibling->right->red = false;
+                  sibling->red = true;
+                  rotate_left (tree, sibling);
+                  sibling = parent->left;
+                }
+              sibling->red = parent->red;
+              parent->red = false;
+              sibling->left->red = false;
+              rotate_right (tree, parent);
+              elem = tree->root;
+              break;
+            }
+        }
+    }
+  if (elem != NULL)
+    elem->red = false;
+}
+
+/* Makes ELEM's right child take its place, with ELEM becoming
+   that child's left child. */
+static void
+rotate_left (struct rb_tree *tree, struct rb_elem *elem)
+{
+  struct rb_elem *right = elem->right;
+
+  elem->right = right->left;
+  if (right->left != NULL)
+    right->left->parent = elem;
+  transplant (tree, elem, right);
+  right->left = elem;
+  elem->parent = right;
+}
+
+/* Makes ELEM's left child take its place, with ELEM becoming
+   that child's right child. */
+static void
+rotate_right (struct rb_tree *tree, struct rb_elem *elem)
+{
+  struct rb_elem *left = elem->left;
+
+  elem->left = left->right;
+  if (left->right != NULL)
+    left->right->parent = elem;
+  transplant (tree, elem, left);
+  left->right = elem;
+  elem->parent = left;
+}
+
+/* Replaces the subtree rooted at OLD by the one rooted at NEW,
+   which may be null, in OLD's parent. */
+static void
+transplant (struct rb_tree *tree, struct rb_elem *old, struct rb_elem *new)
+{
+  if (old->parent == NULL)
+    tree->root = new;
+  else if (old == old->parent->left)
+    old->parent->left = new;
+  else
+    old->parent->right = new;
+  if (new != NULL)
+    new->parent = old->parent;
+}
+
+/* Returns the smallest element in the subtree rooted at ELEM. */
+static struct rb_elem *
+leftmost (struct rb_elem *elem)
+{
+  while (elem->left != NULL)
+    elem = elem->left;
+  return elem;
+}
+
+/* Returns true if ELEM is red.  Null elements are black. */
+static bool
+is_red (const struct rb_elem *elem)
+{
+  return elem != NULL && elem->red;
+}
@@ -0,0 +1,18 @@
+#ifndef __LIB_RDTSC_H
+#define __LIB_RDTSC_H
+
+#include <stdint.h>
+
+/* Returns the CPU's time-stamp counter, which counts clock
+   cycles.  Differences between two readings time short stretches
+   of code, in the kernel or in user programs.  See [IA32-v2b]
+   "RDTSC". */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+#endif /* lib/rdtsc.h */
@@ -1,20 +1,31 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* The bulk memory functions below move whole 32-bit words where
+   they can, using the i386 string instructions for copies and
+   fills.  These rely on the direction flag being clear on entry,
+   which the i386 calling convention guarantees and which the
+   kernel's interrupt entry code restores.  Requests smaller than
+   SMALL_SIZE bytes are handled a byte at a time, since setting up
+   the string instructions would cost more than it saves. */
+#define SMALL_SIZE 16
+
+/* A 32-bit word that may be unaligned and may alias any other
+   object, for word-at-a-time access to byte arrays. */
+typedef uint32_t word_t __attribute__ ((__may_alias__, __aligned__ (1)));
+
+static void copy_forward (unsigned char *, const unsigned char *, size_t);
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
 void *
 memcpy (void *dst_, const void *src_, size_t size) 
 {
-  unsigned char *dst = dst_;
-  const unsigned char *src = src_;
-
-  ASSERT (dst != NULL || size == 0);
-  ASSERT (src != NULL || size == 0);
-
-  while (size-- > 0)
-    *dst++ = *src++;
+  ASSERT (dst_ != NULL || size == 0);
+  ASSERT (src_ != NULL || size == 0);
 
+  copy_forward (dst_, src_, size);
   return dst_;
 }
 
@@ -29,20 +40,38 @@ memmove (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  if (dst < src) 
+  if (dst <= src || dst >= src + size)
     {
-      while (size-- > 0)
-        *dst++ = *src++;
+      /* Copying upward never overwrites a byte of SRC before
+         reading it. */
+      copy_forward (dst, src, size);
     }
-  else 
+  else if (size < SMALL_SIZE)
     {
       dst += size;
       src += size;
       while (size-- > 0)
         *--dst = *--src;
     }
+  else
+    {
+      /* Copy downward: first the odd bytes at the end, one at a
+         time, then the remaining whole words. */
+      int d0, d1, d2;
+      asm volatile ("std\n\t"
+                    "rep movsb\n\t"
+                    "subl $3, %%esi\n\t"
+                    "subl $3, %%edi\n\t"
+                    "movl %6, %%ecx\n\t"
+                    "rep movsl\n\t"
+                    "cld"
+                    : "=&D" (d0), "=&S" (d1), "=&c" (d2)
+                    : "0" (dst + size - 1), "1" (src + size - 1),
+                      "2" (size & 3), "a" (size / 4)
+                    : "memory");
+    }
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -58,6 +87,13 @@ memcmp (const void *a_, const void *b_, size_t size)
   ASSERT (a != NULL || size == 0);
   ASSERT (b != NULL || size == 0);
 
+  /* Skip over equal words, leaving the first difference, if
+     any, to the byte loop. */
+  for (; size >= sizeof (word_t); a += sizeof (word_t),
+         b += sizeof (word_t), size -= sizeof (word_t))
+    if (*(const word_t *) a != *(const word_t *) b)
+      break;
+
   for (; size-- > 0; a++, b++)
     if (*a != *b)
       return *a > *b ? +1 : -1;
@@ -281,9 +317,31 @@ memset (void *dst_, int value, size_t size)
   unsigned char *dst = dst_;
 
   ASSERT (dst != NULL || size == 0);
-  
-  while (size-- > 0)
-    *dst++ = value;
+
+  if (size < SMALL_SIZE)
+    {
+      while (size-- > 0)
+        *dst++ = value;
+    }
+  else
+    {
+      /* Fill bytes up to a word boundary in DST, then whole
+         words, then the bytes left over. */
+      uint32_t word = (value & 0xff) * 0x01010101u;
+      size_t head = -(uintptr_t) dst & 3;
+      int d0, d1;
+
+      size -= head;
+      asm volatile ("rep stosb\n\t"
+                    "movl %4, %%ecx\n\t"
+                    "rep stosl\n\t"
+                    "movl %5, %%ecx\n\t"
+                    "rep stosb"
+                    : "=&D" (d0), "=&c" (d1)
+                    : "0" (dst), "1" (head), "d" (size / 4), "b" (size & 3),
+                      "a" (word)
+                    : "memory");
+    }
 
   return dst_;
 }
@@ -293,10 +351,24 @@ size_t
 strlen (const char *string) 
 {
   const char *p;
+  const uint32_t *w;
 
   ASSERT (string != NULL);
 
-  for (p = string; *p != '\0'; p++)
+  /* Check bytes up to a word boundary, then whole aligned words.
+     An aligned word never crosses a page boundary, so reading
+     past the null terminator within one cannot fault. */
+  for (p = string; (uintptr_t) p & 3; p++)
+    if (*p == '\0')
+      return p - string;
+
+  /* A word has a zero byte if subtracting 1 from each byte
+     borrows into a byte's high bit that was clear before. */
+  for (w = (const uint32_t *) p;
+       ((*w - 0x01010101u) & ~*w & 0x80808080u) == 0; w++)
+    continue;
+
+  for (p = (const char *) w; *p != '\0'; p++)
     continue;
   return p - string;
 }
@@ -373,3 +445,31 @@ strlcat (char *dst, const char *src, size_t size)
   return src_len + dst_len;
 }
 
+/* Copies SIZE bytes upward from SRC to DST.  Bytes up to a word
+   boundary in DST are copied individually, then whole words,
+   then the bytes left over. */
+static void
+copy_forward (unsigned char *dst, const unsigned char *src, size_t size) 
+{
+  if (size < SMALL_SIZE)
+    {
+      while (size-- > 0)
+        *dst++ = *src++;
+    }
+  else
+    {
+      size_t head = -(uintptr_t) dst & 3;
+      int d0, d1, d2;
+
+      size -= head;
+      asm volatile ("rep movsb\n\t"
+                    "movl %6, %%ecx\n\t"
+                    "rep movsl\n\t"
+                    "movl %7, %%ecx\n\t"
+                    "rep movsb"
+                    : "=&D" (d0), "=&S" (d1), "=&c" (d2)
+                    : "0" (dst), "1" (src), "2" (head), "a" (size / 4),
+                      "d" (size & 3)
+                    : "memory");
+    }
+}
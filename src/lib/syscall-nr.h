@@ -28,7 +28,22 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_GETPID,                 /* Obtain this process's identifier. */
+    SYS_PREAD,                  /* Read from a file at an offset. */
+    SYS_PWRITE,                 /* Write to a file at an offset. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV,                 /* Write to a file from several buffers. */
+    SYS_RING_SETUP,             /* Map an I/O ring. */
+    SYS_RING_ENTER,             /* Submit and wait for I/O ring operations. */
+    SYS_COPY_FILE_RANGE,        /* Copy from one file to another. */
+    SYS_SBRK,                   /* Move the end of the heap. */
+    SYS_MMAP_RANGE,             /* Map part of a file, or zeros. */
+    SYS_MSYNC,                  /* Write a mapping back to its file. */
+    SYS_MADVISE,                /* Say how memory will be used. */
+    SYS_PIPE                    /* Create a pipe. */
   };
 
 #endif /* lib/syscall-nr.h */
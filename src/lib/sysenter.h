@@ -0,0 +1,30 @@
+#ifndef __LIB_SYSENTER_H
+#define __LIB_SYSENTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Returns true if the CPU has the SYSENTER and SYSEXIT
+   instructions.  The kernel accepts system calls through
+   SYSENTER exactly when this is true, so user programs can make
+   the same test to decide whether to use it.  See [IA32-v2b]
+   "SYSENTER". */
+static inline bool
+sysenter_supported (void)
+{
+  uint32_t eax, ebx, ecx, edx;
+  unsigned family, model, stepping;
+
+  asm ("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+  family = (eax >> 8) & 0xf;
+  model = (eax >> 4) & 0xf;
+  stepping = eax & 0xf;
+
+  /* The earliest Pentium Pros report SEP but do not implement
+     the instructions. */
+  if (family == 6 && model < 3 && stepping < 3)
+    return false;
+  return (edx & (1u << 11)) != 0;
+}
+
+#endif /* lib/sysenter.h */
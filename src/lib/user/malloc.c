@@ -0,0 +1,423 @@
+#include <malloc.h>
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+
+/* A heap allocator for user programs, after the kernel's
+   (threads/malloc.c).
+
+   The size of each request, in bytes, is rounded up to a power
+   of 2 and assigned to the "descriptor" that manages blocks of
+   that size.  The descriptor keeps a list of free blocks, from
+   which requests are satisfied.  When the list is empty, a new
+   page, called an "arena", is divided into blocks for it.  When
+   every block in an arena is free again, the arena's page is
+   given back.
+
+   Requests too big for any descriptor get a "big block" of
+   whole pages of their own, with the arena header at its start.
+
+   Pages come from a list of free runs of contiguous pages, kept
+   in address order and merged with their neighbors as pages are
+   given back, so that the pages that small blocks and big blocks
+   leave behind can be used again for either.  Only when no run
+   is big enough is the heap grown with sbrk().  A run that ends
+   at the break goes back to the kernel with sbrk() at once, so a
+   program that frees everything leaves its heap as it found
+   it. */
+
+/* Size of a page, the unit in which the heap grows. */
+#define PAGE_SIZE 4096
+
+/* Descriptor. */
+struct desc
+  {
+    size_t block_size;          /* Size of each element in bytes. */
+    size_t blocks_per_arena;    /* Number of blocks in an arena. */
+    struct block *free_list;    /* List of free blocks. */
+  };
+
+/* Magic number for detecting arena corruption. */
+#define ARENA_MAGIC 0x9a548eed
+
+/* Arena. */
+struct arena
+  {
+    unsigned magic;             /* Always set to ARENA_MAGIC. */
+    struct desc *desc;          /* Owning descriptor, null for big block. */
+    size_t free_cnt;            /* Free blocks; pages in big block. */
+  };
+
+/* Free block. */
+struct block
+  {
+    struct block *prev;         /* Previous free block of its size. */
+    struct block *next;         /* Next free block of its size. */
+  };
+
+/* Run of free pages. */
+struct run
+  {
+    size_t page_cnt;            /* Number of pages in the run. */
+    struct run *next;           /* Next run, at a higher address. */
+  };
+
+/* Our set of descriptors. */
+static struct desc descs[10];   /* Descriptors. */
+static size_t desc_cnt;         /* Number of descriptors. */
+
+/* Free runs of pages, in address order. */
+static struct run *free_runs;
+
+static struct arena *block_to_arena (struct block *);
+static struct block *arena_to_block (struct arena *, size_t idx);
+
+/* Initializes the descriptors. */
+static void
+malloc_init (void)
+{
+  size_t block_size;
+
+  for (block_size = 16; block_size < PAGE_SIZE / 2; block_size *= 2)
+    {
+      struct desc *d = &descs[desc_cnt++];
+      ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
+      d->block_size = block_size;
+      d->blocks_per_arena = (PAGE_SIZE - sizeof (struct arena)) / block_size;
+      d->free_list = NULL;
+    }
+}
+
+/* Returns the address just past the end of run R. */
+static char *
+run_end (struct run *r)
+{
+  return (char *) r + r->page_cnt * PAGE_SIZE;
+}
+
+/* Obtains PAGE_CNT contiguous pages, from the first free run
+   that is big enough or else by growing the heap.  Returns a
+   null pointer if the heap cannot grow. */
+static void *
+get_pages (size_t page_cnt)
+{
+  struct run **rp, *r;
+  char *brk;
+  size_t pad;
+
+  for (rp = &free_runs; (r = *rp) != NULL; rp = &r->next)
+    if (r->page_cnt >= page_cnt)
+      {
+        if (r->page_cnt > page_cnt)
+          {
+            /* Leave the rest of the run on the list. */
+            struct run *rest = (struct run *) ((char *) r
+                                               + page_cnt * PAGE_SIZE);
+            rest->page_cnt = r->page_cnt - page_cnt;
+            rest->next = r->next;
+            *rp = rest;
+          }
+        else
+          *rp = r->next;
+        return r;
+      }
+
+  /* Grow the heap, first bringing the break up to a page
+     boundary in case the program has called sbrk() itself. */
+  brk = sbrk (0);
+  pad = ROUND_UP ((uintptr_t) brk, PAGE_SIZE) - (uintptr_t) brk;
+  if (page_cnt > (INTPTR_MAX - pad) / PAGE_SIZE
+      || sbrk (pad + page_cnt * PAGE_SIZE) == (void *) -1)
+    return NULL;
+  return brk + pad;
+}
+
+/* Gives back the PAGE_CNT pages at PAGES, merging them into the
+   free runs next to them.  If the heap now ends in a free run,
+   shrinks the heap to give that run back to the kernel. */
+static void
+free_pages (void *pages, size_t page_cnt)
+{
+  struct run *r = pages;
+  struct run *prev = NULL, *next = free_runs;
+  struct run **last;
+
+  ASSERT (page_cnt > 0);
+  while (next != NULL && next < r)
+    {
+      prev = next;
+      next = next->next;
+    }
+
+  r->page_cnt = page_cnt;
+  r->next = next;
+  if (next != NULL && run_end (r) == (char *) next)
+    {
+      r->page_cnt += next->page_cnt;
+      r->next = next->next;
+    }
+  if (prev == NULL)
+    free_runs = r;
+  else if (run_end (prev) == (char *) r)
+    {
+      prev->page_cnt += r->page_cnt;
+      prev->next = r->next;
+    }
+  else
+    prev->next = r;
+
+  /* Find the last run and give it back if it ends at the break. */
+  for (last = &free_runs; (*last)->next != NULL; last = &(*last)->next)
+    continue;
+  if (run_end (*last) == (char *) sbrk (0))
+    {
+      intptr_t size = (*last)->page_cnt * PAGE_SIZE;
+      *last = NULL;
+      sbrk (-size);
+    }
+}
+
+/* Adds block B to descriptor D's free list. */
+static void
+push_block (struct desc *d, struct block *b)
+{
+  b->prev = NULL;
+  b->next = d->free_list;
+  if (b->next != NULL)
+    b->next->prev = b;
+  d->free_list = b;
+}
+
+/* Removes block B from descriptor D's free list. */
+static void
+remove_block (struct desc *d, struct block *b)
+{
+  if (b->prev != NULL)
+    b->prev->next = b->next;
+  else
+    d->free_list = b->next;
+  if (b->next != NULL)
+    b->next->prev = b->prev;
+}
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if memory is not available. */
+void *
+malloc (size_t size)
+{
+  struct desc *d;
+  struct block *b;
+  struct arena *a;
+
+  /* A null pointer satisfies a request for 0 bytes. */
+  if (size == 0)
+    return NULL;
+
+  if (desc_cnt == 0)
+    malloc_init ();
+
+  /* Find the smallest descriptor that satisfies a SIZE-byte
+     request. */
+  for (d = descs; d < descs + desc_cnt; d++)
+    if (d->block_size >= size)
+      break;
+  if (d == descs + desc_cnt)
+    {
+      /* SIZE is too big for any descriptor.
+         Allocate enough pages to hold SIZE plus an arena. */
+      size_t page_cnt;
+
+      if (size > SIZE_MAX - sizeof *a - PAGE_SIZE)
+        return NULL;
+      page_cnt = DIV_ROUND_UP (size + sizeof *a, PAGE_SIZE);
+      a = get_pages (page_cnt);
+      if (a == NULL)
+        return NULL;
+
+      /* Initialize the arena to indicate a big block of PAGE_CNT
+         pages, and return it. */
+      a->magic = ARENA_MAGIC;
+      a->desc = NULL;
+      a->free_cnt = page_cnt;
+      return a + 1;
+    }
+
+  /* If the free list is empty, create a new arena. */
+  if (d->free_list == NULL)
+    {
+      size_t i;
+
+      a = get_pages (1);
+      if (a == NULL)
+        return NULL;
+
+      /* Initialize arena and add its blocks to the free list. */
+      a->magic = ARENA_MAGIC;
+      a->desc = d;
+      a->free_cnt = d->blocks_per_arena;
+      for (i = d->blocks_per_arena; i-- > 0; )
+        push_block (d, arena_to_block (a, i));
+    }
+
+  /* Get a block from free list and return it. */
+  b = d->free_list;
+  remove_block (d, b);
+  a = block_to_arena (b);
+  a->free_cnt--;
+  return b;
+}
+
+/* Allocates and return A times B bytes initialized to zeroes.
+   Returns a null pointer if memory is not available. */
+void *
+calloc (size_t a, size_t b)
+{
+  void *p;
+  size_t size;
+
+  /* Calculate block size and make sure it fits in size_t. */
+  if (b != 0 && a > SIZE_MAX / b)
+    return NULL;
+  size = a * b;
+
+  /* Allocate and zero memory. */
+  p = malloc (size);
+  if (p != NULL)
+    memset (p, 0, size);
+
+  return p;
+}
+
+/* Returns the number of bytes allocated for BLOCK. */
+static size_t
+block_size (void *block)
+{
+  struct block *b = block;
+  struct arena *a = block_to_arena (b);
+  struct desc *d = a->desc;
+
+  return d != NULL ? d->block_size : PAGE_SIZE * a->free_cnt - sizeof *a;
+}
+
+/* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
+   moving it in the process.
+   If successful, returns the new block; on failure, returns a
+   null pointer.
+   A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK).
+   A block that already has room for NEW_SIZE bytes stays where
+   it is, and a big block that shrinks gives back the pages it
+   no longer needs. */
+void *
+realloc (void *old_block, size_t new_size)
+{
+  if (new_size == 0)
+    {
+      free (old_block);
+      return NULL;
+    }
+  else if (old_block != NULL && new_size <= block_size (old_block))
+    {
+      struct arena *a = block_to_arena (old_block);
+      if (a->desc == NULL)
+        {
+          size_t page_cnt = DIV_ROUND_UP (new_size + sizeof *a, PAGE_SIZE);
+          if (page_cnt < a->free_cnt)
+            {
+              free_pages ((char *) a + page_cnt * PAGE_SIZE,
+                          a->free_cnt - page_cnt);
+              a->free_cnt = page_cnt;
+            }
+        }
+      return old_block;
+    }
+  else
+    {
+      void *new_block = malloc (new_size);
+      if (old_block != NULL && new_block != NULL)
+        {
+          size_t old_size = block_size (old_block);
+          size_t min_size = new_size < old_size ? new_size : old_size;
+          memcpy (new_block, old_block, min_size);
+          free (old_block);
+        }
+      return new_block;
+    }
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void
+free (void *p)
+{
+  if (p != NULL)
+    {
+      struct block *b = p;
+      struct arena *a = block_to_arena (b);
+      struct desc *d = a->desc;
+
+      if (d != NULL)
+        {
+          /* It's a normal block.  We handle it here. */
+
+#ifndef NDEBUG
+          /* Clear the block to help detect use-after-free bugs. */
+          memset (b, 0xcc, d->block_size);
+#endif
+
+          /* Add block to free list. */
+          push_block (d, b);
+
+          /* If the arena is now entirely unused, free it. */
+          if (++a->free_cnt >= d->blocks_per_arena)
+            {
+              size_t i;
+
+              ASSERT (a->free_cnt == d->blocks_per_arena);
+              for (i = 0; i < d->blocks_per_arena; i++)
+                remove_block (d, arena_to_block (a, i));
+              a->magic = 0;
+              free_pages (a, 1);
+            }
+        }
+      else
+        {
+          /* It's a big block.  Free its pages. */
+          a->magic = 0;
+          free_pages (a, a->free_cnt);
+        }
+    }
+}
+
+/* Returns the arena that block B is inside. */
+static struct arena *
+block_to_arena (struct block *b)
+{
+  struct arena *a = (struct arena *) ROUND_DOWN ((uintptr_t) b, PAGE_SIZE);
+
+  /* Check that the arena is valid. */
+  ASSERT (a != NULL);
+  ASSERT (a->magic == ARENA_MAGIC);
+
+  /* Check that the block is properly aligned for the arena. */
+  ASSERT (a->desc == NULL
+          || ((uintptr_t) b % PAGE_SIZE - sizeof *a)
+             % a->desc->block_size == 0);
+  ASSERT (a->desc != NULL || (uintptr_t) b % PAGE_SIZE == sizeof *a);
+
+  return a;
+}
+
+/* Returns the (IDX - 1)'th block within arena A. */
+static struct block *
+arena_to_block (struct arena *a, size_t idx)
+{
+  ASSERT (a != NULL);
+  ASSERT (a->magic == ARENA_MAGIC);
+  ASSERT (idx < a->desc->blocks_per_arena);
+  return (struct block *) ((uint8_t *) a
+                           + sizeof *a
+                           + idx * a->desc->block_size);
+}
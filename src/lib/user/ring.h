@@ -0,0 +1,77 @@
+#ifndef __LIB_USER_RING_H
+#define __LIB_USER_RING_H
+
+#include <stdint.h>
+
+/* I/O ring, shared between a process and the kernel.
+
+   ring_setup() maps a ring at a page-aligned user address: a
+   page holding the submission queue, a page holding the
+   completion queue, and then the given number of buffer pages.
+   The buffers and file names that operations name must lie in
+   the buffer pages, which the kernel can reach at any time.
+
+   To submit operations, the process fills in entries at the tail
+   of the submission queue, advances the tail, and calls
+   ring_enter().  The kernel takes entries from the head.  Each
+   operation produces one completion entry at the tail of the
+   completion queue, whose result is what the corresponding
+   system call would have returned, and the process takes
+   completions from the head.  Completions need not come in the
+   order of submission.
+
+   Heads and tails count entries from 0 without wrapping around;
+   an entry's slot is its count modulo RING_ENTRIES. */
+
+#define RING_ENTRIES 64         /* Entries in each queue. */
+#define RING_QUEUE_SIZE 4096    /* Bytes taken by each queue. */
+#define RING_BUF_MAX 32         /* Maximum number of buffer pages. */
+
+/* Operations. */
+enum ring_op
+  {
+    RING_NOP,                   /* Do nothing. */
+    RING_READ,                  /* Like pread (fd, buf, len, offset). */
+    RING_WRITE,                 /* Like pwrite (fd, buf, len, offset). */
+    RING_OPEN,                  /* Like open() of the LEN-byte name at BUF. */
+    RING_CLOSE                  /* Like close (fd), but returns 0. */
+  };
+
+/* Submission queue entry. */
+struct ring_sqe
+  {
+    uint32_t op;                /* A ring_op. */
+    int32_t fd;                 /* File descriptor. */
+    void *buf;                  /* Buffer or file name. */
+    uint32_t len;               /* Bytes in BUF. */
+    uint32_t offset;            /* Offset in file. */
+    uint32_t user_data;         /* Passed through to the completion. */
+  };
+
+/* Completion queue entry. */
+struct ring_cqe
+  {
+    uint32_t user_data;         /* From the submission. */
+    int32_t result;             /* Result of the operation. */
+  };
+
+/* Submission queue.  The process writes TAIL, the kernel HEAD. */
+struct ring_sq
+  {
+    volatile uint32_t head, tail;
+    struct ring_sqe sqes[RING_ENTRIES];
+  };
+
+/* Completion queue.  The kernel writes TAIL, the process HEAD. */
+struct ring_cq
+  {
+    volatile uint32_t head, tail;
+    struct ring_cqe cqes[RING_ENTRIES];
+  };
+
+/* Parts of the ring mapped at RING. */
+#define RING_SQ(RING) ((struct ring_sq *) (RING))
+#define RING_CQ(RING) ((struct ring_cq *) ((char *) (RING) + RING_QUEUE_SIZE))
+#define RING_BUF(RING) ((char *) (RING) + 2 * RING_QUEUE_SIZE)
+
+#endif /* lib/user/ring.h */
@@ -1,65 +1,60 @@
 #include <syscall.h>
+#include <sysenter.h>
 #include "../syscall-nr.h"
 
-/* Invokes syscall NUMBER, passing no arguments, and returns the
-   return value as an `int'. */
-#define syscall0(NUMBER)                                        \
-        ({                                                      \
-          int retval;                                           \
-          asm volatile                                          \
-            ("pushl %[number]; int $0x30; addl $4, %%esp"       \
-               : "=a" (retval)                                  \
-               : [number] "i" (NUMBER)                          \
-               : "memory");                                     \
-          retval;                                               \
-        })
+/* Returns nonzero if system calls should enter the kernel
+   through SYSENTER, which is cheaper than int $0x31 but not found
+   on all CPUs.  The kernel accepts both. */
+static inline int
+use_sysenter (void)
+{
+  static int known = -1;
+  if (known < 0)
+    known = sysenter_supported ();
+  return known;
+}
 
-/* Invokes syscall NUMBER, passing argument ARG0, and returns the
-   return value as an `int'. */
-#define syscall1(NUMBER, ARG0)                                           \
-        ({                                                               \
-          int retval;                                                    \
-          asm volatile                                                   \
-            ("pushl %[arg0]; pushl %[number]; int $0x30; addl $8, %%esp" \
-               : "=a" (retval)                                           \
-               : [number] "i" (NUMBER),                                  \
-                 [arg0] "g" (ARG0)                                       \
-               : "memory");                                              \
-          retval;                                                        \
-        })
+/* Enters the kernel to make the system call whose number is in
+   %eax and arguments in %ebx, %ecx, %edx, %esi and %edi, through
+   SYSENTER if operand SYSENTER is nonzero, otherwise through
+   int $0x31.  SYSEXIT returns to the address in %edx with the
+   stack pointer in %ecx, so the arguments in those registers
+   travel on the stack instead, and both registers are clobbered
+   either way. */
+#define SYSCALL_ENTER                                           \
+        "cmpl $0, %[sysenter]; je 1f; "                         \
+        "pushl %%edx; pushl %%ecx; movl %%esp, %%ecx; "         \
+        "movl $2f, %%edx; sysenter; 2: addl $8, %%esp; jmp 3f; " \
+        "1: int $0x31; 3: "
 
-/* Invokes syscall NUMBER, passing arguments ARG0 and ARG1, and
-   returns the return value as an `int'. */
-#define syscall2(NUMBER, ARG0, ARG1)                            \
+/* Invokes syscall NUMBER, passing arguments ARG0 through ARG4,
+   and returns the return value as an `int'. */
+#define syscall5(NUMBER, ARG0, ARG1, ARG2, ARG3, ARG4)          \
         ({                                                      \
           int retval;                                           \
+          int arg1 = (int) (ARG1), arg2 = (int) (ARG2);         \
           asm volatile                                          \
-            ("pushl %[arg1]; pushl %[arg0]; "                   \
-             "pushl %[number]; int $0x30; addl $12, %%esp"      \
-               : "=a" (retval)                                  \
-               : [number] "i" (NUMBER),                         \
-                 [arg0] "g" (ARG0),                             \
-                 [arg1] "g" (ARG1)                              \
+            (SYSCALL_ENTER                                      \
+               : "=a" (retval), "+c" (arg1), "+d" (arg2)        \
+               : "a" (NUMBER),                                  \
+                 "b" (ARG0),                                    \
+                 "S" (ARG3),                                    \
+                 "D" (ARG4),                                    \
+                 [sysenter] "rm" (use_sysenter ())              \
                : "memory");                                     \
           retval;                                               \
         })
 
-/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, and
-   ARG2, and returns the return value as an `int'. */
+/* Invokes syscall NUMBER with fewer arguments, and returns the
+   return value as an `int'. */
+#define syscall0(NUMBER) syscall5 (NUMBER, 0, 0, 0, 0, 0)
+#define syscall1(NUMBER, ARG0) syscall5 (NUMBER, ARG0, 0, 0, 0, 0)
+#define syscall2(NUMBER, ARG0, ARG1)                            \
+        syscall5 (NUMBER, ARG0, ARG1, 0, 0, 0)
 #define syscall3(NUMBER, ARG0, ARG1, ARG2)                      \
-        ({                                                      \
-          int retval;                                           \
-          asm volatile                                          \
-            ("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "    \
-             "pushl %[number]; int $0x30; addl $16, %%esp"      \
-               : "=a" (retval)                                  \
-               : [number] "i" (NUMBER),                         \
-                 [arg0] "g" (ARG0),                             \
-                 [arg1] "g" (ARG1),                             \
-                 [arg2] "g" (ARG2)                              \
-               : "memory");                                     \
-          retval;                                               \
-        })
+        syscall5 (NUMBER, ARG0, ARG1, ARG2, 0, 0)
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        syscall5 (NUMBER, ARG0, ARG1, ARG2, ARG3, 0)
 
 void
 halt (void) 
@@ -182,3 +177,90 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+pid_t
+getpid (void)
+{
+  return (pid_t) syscall0 (SYS_GETPID);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+bool
+ring_setup (void *addr, unsigned buf_pages)
+{
+  return syscall2 (SYS_RING_SETUP, addr, buf_pages);
+}
+
+int
+ring_enter (unsigned to_submit, unsigned min_complete)
+{
+  return syscall2 (SYS_RING_ENTER, to_submit, min_complete);
+}
+
+int
+copy_file_range (int fd_in, int fd_out, unsigned length)
+{
+  return syscall3 (SYS_COPY_FILE_RANGE, fd_in, fd_out, length);
+}
+
+mapid_t
+mmap_range (void *addr, size_t length, int flags, int fd, unsigned offset)
+{
+  return syscall5 (SYS_MMAP_RANGE, addr, length, flags, fd, offset);
+}
+
+bool
+msync (mapid_t mapid)
+{
+  return syscall1 (SYS_MSYNC, mapid);
+}
+
+bool
+madvise (void *addr, size_t length, int advice)
+{
+  return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+void *
+sbrk (intptr_t increment)
+{
+  return (void *) syscall1 (SYS_SBRK, increment);
+}
+
+/* Moves the break to ADDR.  Returns 0 if successful, -1
+   otherwise. */
+int
+brk (void *addr)
+{
+  char *old_brk = sbrk (0);
+  return sbrk ((char *) addr - old_brk) != (void *) -1 ? 0 : -1;
+}
+
+int
+pipe (int fds[2])
+{
+  return syscall1 (SYS_PIPE, fds);
+}
@@ -2,6 +2,8 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <debug.h>
 
 /* Process identifier. */
@@ -12,9 +14,31 @@ typedef int pid_t;
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
 
+/* Flags for mmap_range(). */
+#define MAP_PRIVATE 0           /* Changes stay in the process. */
+#define MAP_SHARED 1            /* Changes go to the file, and all
+                                   processes mapping it share them. */
+#define MAP_ANON 2              /* Map zeros, not a file. */
+
+/* Advice for madvise(). */
+#define MADV_NORMAL 0           /* No special treatment. */
+#define MADV_SEQUENTIAL 1       /* Will be read in order. */
+#define MADV_WILLNEED 2         /* Will be used soon. */
+#define MADV_DONTNEED 3         /* Will not be used soon. */
+
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* A buffer for readv() and writev(). */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Size of buffer in bytes. */
+  };
+
+/* Maximum number of buffers passed to readv() or writev(). */
+#define IOV_MAX 64
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
@@ -45,4 +69,21 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+pid_t getpid (void);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+bool ring_setup (void *addr, unsigned buf_pages);
+int ring_enter (unsigned to_submit, unsigned min_complete);
+int copy_file_range (int fd_in, int fd_out, unsigned length);
+mapid_t mmap_range (void *addr, size_t length, int flags, int fd,
+                    unsigned offset);
+bool msync (mapid_t);
+bool madvise (void *addr, size_t length, int advice);
+void *sbrk (intptr_t increment);
+int brk (void *addr);
+int pipe (int fds[2]);
+
 #endif /* lib/user/syscall.h */
@@ -53,6 +53,17 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"fair-share-2", test_fair_share_2},
+    {"fair-share-20", test_fair_share_20},
+    {"fair-share-nice-2", test_fair_share_nice_2},
+    {"fair-share-nice-10", test_fair_share_nice_10},
+    {"rwlock-writer-pref", test_rwlock_writer_pref},
+    {"rwlock-donate", test_rwlock_donate},
+    {"rwlock-read-donate", test_rwlock_read_donate},
+    {"seqlock", test_seqlock},
+    {"seqlock-intr", test_seqlock_intr},
+    {"palloc-fragment", test_palloc_fragment},
+    {"malloc-fragment", test_malloc_fragment},
   };  
 #endif
 
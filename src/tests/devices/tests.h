@@ -37,6 +37,17 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_fair_share_2;
+extern test_func test_fair_share_20;
+extern test_func test_fair_share_nice_2;
+extern test_func test_fair_share_nice_10;
+extern test_func test_rwlock_writer_pref;
+extern test_func test_rwlock_donate;
+extern test_func test_rwlock_read_donate;
+extern test_func test_seqlock;
+extern test_func test_seqlock_intr;
+extern test_func test_palloc_fragment;
+extern test_func test_malloc_fragment;
 #endif
 
 void msg (const char *, ...);
@@ -0,0 +1,158 @@
+/* Test program for lib/kernel/bitmap.c.
+
+   Checks the range operations and bitmap_scan() against simple
+   bit-at-a-time reference versions built on bitmap_test(), on
+   bitmaps both below and above the size at which a summary level
+   is kept, then times both scans on a mostly full multi-megabit
+   bitmap.
+
+   This is not a test we will run on your submitted tasks.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/test.h"
+
+/* Number of random operations applied to each bitmap. */
+#define OP_CNT 2000
+
+/* Number of bits in the bitmap used for timing. */
+#define BIG_BITS (4 * 1024 * 1024)
+
+/* Number of scans timed. */
+#define SCAN_CNT 10
+
+static void test_size (size_t bit_cnt);
+static size_t ref_count (const struct bitmap *, size_t start, size_t cnt,
+                         bool value);
+static size_t ref_scan (const struct bitmap *, size_t start, size_t cnt,
+                        bool value);
+static void time_scans (void);
+
+/* Test bitmap range operations and scanning. */
+void
+test (void)
+{
+  static const size_t sizes[] = {1, 31, 32, 33, 1000, 8192, 20000};
+  size_t i;
+
+  printf ("testing sizes:");
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    {
+      printf (" %zu", sizes[i]);
+      test_size (sizes[i]);
+    }
+  printf (" done\n");
+
+  time_scans ();
+  printf ("bitmap: PASS\n");
+}
+
+/* Applies OP_CNT random range updates, counts and scans to a
+   bitmap of BIT_CNT bits, checking each against the reference
+   versions. */
+static void
+test_size (size_t bit_cnt)
+{
+  struct bitmap *b = bitmap_create (bit_cnt);
+  int i;
+
+  ASSERT (b != NULL);
+  for (i = 0; i < OP_CNT; i++)
+    {
+      size_t start = random_ulong () % bit_cnt;
+      size_t cnt = random_ulong () % (bit_cnt - start + 1);
+      bool value = random_ulong () % 2;
+
+      switch (random_ulong () % 4)
+        {
+        case 0:
+          /* Mostly fill the bitmap, so that scans for false bits
+             have long stretches to skip. */
+          bitmap_set_multiple (b, start, cnt, random_ulong () % 8 != 0);
+          break;
+
+        case 1:
+          ASSERT (bitmap_count (b, start, cnt, value)
+                  == ref_count (b, start, cnt, value));
+          ASSERT (bitmap_contains (b, start, cnt, value)
+                  == (ref_count (b, start, cnt, value) > 0));
+          break;
+
+        case 2:
+          cnt = random_ulong () % 8;
+          ASSERT (bitmap_scan (b, start, cnt, value)
+                  == ref_scan (b, start, cnt, value));
+          break;
+
+        case 3:
+          bitmap_flip (b, start);
+          break;
+        }
+    }
+  bitmap_destroy (b);
+}
+
+/* Returns the number of bits in B between START and START + CNT
+   that are set to VALUE, testing one bit at a time. */
+static size_t
+ref_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
+{
+  size_t i, value_cnt = 0;
+
+  for (i = 0; i < cnt; i++)
+    if (bitmap_test (b, start + i) == value)
+      value_cnt++;
+  return value_cnt;
+}
+
+/* Finds the first group of CNT bits in B at or after START that
+   are all set to VALUE, testing one bit at a time, as
+   bitmap_scan() used to. */
+static size_t
+ref_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
+{
+  if (cnt <= bitmap_size (b))
+    {
+      size_t last = bitmap_size (b) - cnt;
+      size_t i;
+      for (i = start; i <= last; i++)
+        if (ref_count (b, i, cnt, !value) == 0)
+          return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Fills a BIG_BITS-bit bitmap except for a few bits near the
+   end, then prints the time taken by SCAN_CNT scans for a free
+   bit using the reference and the real bitmap_scan(). */
+static void
+time_scans (void)
+{
+  struct bitmap *b = bitmap_create (BIG_BITS);
+  size_t hole = BIG_BITS - 100;
+  int64_t start;
+  int i;
+
+  ASSERT (b != NULL);
+  bitmap_set_all (b, true);
+  bitmap_reset (b, hole);
+
+  start = timer_ticks ();
+  for (i = 0; i < SCAN_CNT; i++)
+    ASSERT (ref_scan (b, 0, 1, false) == hole);
+  printf ("bit-at-a-time scan: %"PRId64" ticks\n", timer_elapsed (start));
+
+  start = timer_ticks ();
+  for (i = 0; i < SCAN_CNT; i++)
+    ASSERT (bitmap_scan (b, 0, 1, false) == hole);
+  printf ("bitmap_scan: %"PRId64" ticks\n", timer_elapsed (start));
+
+  bitmap_destroy (b);
+}
@@ -0,0 +1,147 @@
+/* Test program for lib/kernel/hash.c.
+
+   Inserts, finds and deletes a large number of elements, checking
+   that every element stays reachable while the table resizes
+   itself, then measures the worst-case cost of a single insertion.
+   Because a resize migrates only a few buckets per operation, the
+   maximum should stay within a small multiple of the mean rather
+   than growing with the size of the table.
+
+   This is not a test we will run on your submitted tasks.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <hash.h>
+#include <inttypes.h>
+#include <rdtsc.h>
+#include <stdio.h>
+#include "threads/malloc.h"
+#include "threads/test.h"
+
+/* Number of elements inserted. */
+#define ELEM_CNT 16384
+
+/* A hash table element. */
+struct value
+  {
+    struct hash_elem elem;      /* Hash element. */
+    int value;                  /* Item value. */
+  };
+
+static unsigned value_hash (const struct hash_elem *, void *);
+static bool value_less (const struct hash_elem *, const struct hash_elem *,
+                        void *);
+static void check_all (struct hash *, struct value[], int cnt);
+static void time_inserts (struct value[], bool reserve);
+
+/* Test the hash table implementation. */
+void
+test (void)
+{
+  struct value *values = malloc (sizeof *values * ELEM_CNT);
+  struct hash h;
+  int i;
+
+  ASSERT (values != NULL);
+  for (i = 0; i < ELEM_CNT; i++)
+    values[i].value = i;
+
+  /* Grow from empty, checking everything along the way. */
+  printf ("testing insertion:");
+  ASSERT (hash_init (&h, value_hash, value_less, NULL));
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      ASSERT (hash_insert (&h, &values[i].elem) == NULL);
+      if (i % 1024 == 0)
+        {
+          printf (" %d", i);
+          check_all (&h, values, i + 1);
+        }
+    }
+  check_all (&h, values, ELEM_CNT);
+  printf (" done\n");
+
+  /* Shrink back down, deleting in scrambled order. */
+  printf ("testing deletion:");
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      struct value key;
+      key.value = (i * 7919) % ELEM_CNT;
+      ASSERT (hash_delete (&h, &key.elem) == &values[key.value].elem);
+      ASSERT (hash_find (&h, &key.elem) == NULL);
+    }
+  ASSERT (hash_empty (&h));
+  printf (" done\n");
+  hash_destroy (&h, NULL);
+
+  time_inserts (values, false);
+  time_inserts (values, true);
+
+  free (values);
+  printf ("hash: PASS\n");
+}
+
+/* Returns the hash of the value in E. */
+static unsigned
+value_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct value, elem)->value);
+}
+
+/* Returns true if value A is less than value B, false
+   otherwise. */
+static bool
+value_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct value *a = hash_entry (a_, struct value, elem);
+  const struct value *b = hash_entry (b_, struct value, elem);
+
+  return a->value < b->value;
+}
+
+/* Verifies that H contains exactly the first CNT elements of
+   VALUES. */
+static void
+check_all (struct hash *h, struct value values[], int cnt)
+{
+  int i;
+
+  ASSERT (hash_size (h) == (size_t) cnt);
+  for (i = 0; i < cnt; i++)
+    ASSERT (hash_find (h, &values[i].elem) == &values[i].elem);
+}
+
+/* Prints the mean and maximum number of cycles taken to insert
+   each element of VALUES into a new table, first calling
+   hash_reserve() if RESERVE is true. */
+static void
+time_inserts (struct value values[], bool reserve)
+{
+  struct hash h;
+  uint64_t total = 0, max = 0;
+  int i;
+
+  ASSERT (hash_init (&h, value_hash, value_less, NULL));
+  if (reserve)
+    ASSERT (hash_reserve (&h, ELEM_CNT));
+
+  for (i = 0; i < ELEM_CNT; i++)
+    {
+      uint64_t start = rdtsc ();
+      uint64_t elapsed;
+
+      hash_insert (&h, &values[i].elem);
+      elapsed = rdtsc () - start;
+      total += elapsed;
+      if (elapsed > max)
+        max = elapsed;
+    }
+  hash_destroy (&h, NULL);
+
+  printf ("%s: %d inserts, mean %"PRIu64" cycles, max %"PRIu64" cycles\n",
+          reserve ? "reserved" : "growing", ELEM_CNT,
+          total / ELEM_CNT, max);
+}
@@ -0,0 +1,164 @@
+/* Test program for lib/kernel/intmap.c.
+
+   Checks insertion, lookup and removal against a reference array
+   over a long random sequence of operations, then compares the
+   cost of lookups in an intmap and in a struct hash keyed the
+   same way, at table sizes typical of per-process descriptor,
+   mapping and child tables.
+
+   This is not a test we will run on your submitted tasks.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <hash.h>
+#include <intmap.h>
+#include <inttypes.h>
+#include <random.h>
+#include <rdtsc.h>
+#include <stdio.h>
+#include "threads/test.h"
+
+/* Keys used by the random test are drawn from [0, KEY_RANGE). */
+#define KEY_RANGE 512
+
+/* Number of random operations performed. */
+#define OP_CNT 100000
+
+/* Number of lookups timed at each table size. */
+#define LOOKUP_CNT 100000
+
+/* A hash table element keyed like an intmap entry. */
+struct value
+  {
+    struct hash_elem elem;      /* Hash element. */
+    int key;                    /* Key. */
+  };
+
+static unsigned value_hash (const struct hash_elem *, void *);
+static bool value_less (const struct hash_elem *, const struct hash_elem *,
+                        void *);
+static void test_random (void);
+static void time_lookups (int size);
+
+/* Test the integer map implementation. */
+void
+test (void)
+{
+  static const int sizes[] = {4, 16, 64, 256};
+  size_t i;
+
+  test_random ();
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    time_lookups (sizes[i]);
+  printf ("intmap: PASS\n");
+}
+
+/* Applies OP_CNT random insertions, lookups and removals to an
+   intmap, checking each result against a plain array. */
+static void
+test_random (void)
+{
+  static struct value values[KEY_RANGE];
+  static bool present[KEY_RANGE];
+  struct intmap map;
+  size_t cnt = 0;
+  int i;
+
+  printf ("testing random operations:");
+  intmap_init (&map);
+  for (i = 0; i < KEY_RANGE; i++)
+    values[i].key = i;
+
+  for (i = 0; i < OP_CNT; i++)
+    {
+      int key = random_ulong () % KEY_RANGE;
+
+      if (!present[key])
+        {
+          ASSERT (intmap_find (&map, key) == NULL);
+          ASSERT (intmap_insert (&map, key, &values[key]));
+          present[key] = true;
+          cnt++;
+        }
+      else if (random_ulong () % 2)
+        {
+          ASSERT (intmap_remove (&map, key) == &values[key]);
+          ASSERT (intmap_find (&map, key) == NULL);
+          present[key] = false;
+          cnt--;
+        }
+      else
+        ASSERT (intmap_find (&map, key) == &values[key]);
+
+      ASSERT (intmap_size (&map) == cnt);
+      if (i % 10000 == 0)
+        printf (" %d", i);
+    }
+  intmap_destroy (&map, NULL);
+  printf (" done\n");
+}
+
+/* Returns the hash of the key in E. */
+static unsigned
+value_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_int (hash_entry (e, struct value, elem)->key);
+}
+
+/* Returns true if key A is less than key B, false otherwise. */
+static bool
+value_less (const struct hash_elem *a_, const struct hash_elem *b_,
+            void *aux UNUSED)
+{
+  const struct value *a = hash_entry (a_, struct value, elem);
+  const struct value *b = hash_entry (b_, struct value, elem);
+
+  return a->key < b->key;
+}
+
+/* Fills an intmap and a struct hash with SIZE keys numbered the
+   way descriptors and mapping ids are, from 2 upward, then prints
+   the mean cycles per lookup in each over LOOKUP_CNT lookups of
+   keys that are present. */
+static void
+time_lookups (int size)
+{
+  static struct value values[KEY_RANGE];
+  struct intmap map;
+  struct hash h;
+  uint64_t start, map_cycles, hash_cycles;
+  int i;
+
+  ASSERT (size <= KEY_RANGE);
+  intmap_init (&map);
+  ASSERT (hash_init (&h, value_hash, value_less, NULL));
+  for (i = 0; i < size; i++)
+    {
+      values[i].key = i + 2;
+      ASSERT (intmap_insert (&map, values[i].key, &values[i]));
+      ASSERT (hash_insert (&h, &values[i].elem) == NULL);
+    }
+
+  start = rdtsc ();
+  for (i = 0; i < LOOKUP_CNT; i++)
+    ASSERT (intmap_find (&map, i % size + 2) != NULL);
+  map_cycles = rdtsc () - start;
+
+  start = rdtsc ();
+  for (i = 0; i < LOOKUP_CNT; i++)
+    {
+      struct value key;
+      key.key = i % size + 2;
+      ASSERT (hash_find (&h, &key.elem) != NULL);
+    }
+  hash_cycles = rdtsc () - start;
+
+  printf ("%d keys: intmap %"PRIu64" cycles/lookup, "
+          "hash %"PRIu64" cycles/lookup\n",
+          size, map_cycles / LOOKUP_CNT, hash_cycles / LOOKUP_CNT);
+
+  intmap_destroy (&map, NULL);
+  hash_destroy (&h, NULL);
+}
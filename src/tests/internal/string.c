@@ -0,0 +1,180 @@
+/* Test program for the bulk memory functions in lib/string.c.
+
+   Checks memcpy(), memmove(), memset(), memcmp() and strlen()
+   against simple byte-at-a-time reference versions for every
+   combination of source and destination alignment and a range
+   of sizes, then times each function on page-size blocks.
+
+   This is not a test we will run on your submitted tasks.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/test.h"
+#include "threads/vaddr.h"
+
+/* Largest size tested, in bytes. */
+#define MAX_SIZE 100
+
+/* Size of each buffer: room for MAX_SIZE bytes at any alignment,
+   plus slack on both sides to catch overruns. */
+#define BUF_SIZE (MAX_SIZE + 32)
+
+/* Number of times each function is run on a page when timing. */
+#define TIMING_ITERATIONS 10000
+
+static void test_alignments (size_t dst_ofs, size_t src_ofs, size_t size);
+static void ref_move (uint8_t *, const uint8_t *, size_t);
+static int ref_compare (const uint8_t *, const uint8_t *, size_t);
+static int sign (int);
+static void time_functions (void);
+
+/* Test bulk memory functions. */
+void
+test (void) 
+{
+  size_t dst_ofs, src_ofs, size;
+
+  printf ("testing alignments:");
+  for (dst_ofs = 0; dst_ofs < 8; dst_ofs++)
+    {
+      printf (" %zu", dst_ofs);
+      for (src_ofs = 0; src_ofs < 8; src_ofs++)
+        for (size = 0; size <= MAX_SIZE; size++)
+          test_alignments (dst_ofs, src_ofs, size);
+    }
+  printf (" done\n");
+
+  time_functions ();
+  printf ("string: PASS\n");
+}
+
+/* Checks each function with the given destination and source
+   offsets within their buffers, for blocks of SIZE bytes. */
+static void
+test_alignments (size_t dst_ofs, size_t src_ofs, size_t size) 
+{
+  static uint8_t src[BUF_SIZE], dst[BUF_SIZE], ref[BUF_SIZE];
+  size_t i;
+  int value;
+
+  /* memcpy(). */
+  random_bytes (src, BUF_SIZE);
+  random_bytes (dst, BUF_SIZE);
+  memcpy (ref, dst, BUF_SIZE);
+  ASSERT (memcpy (dst + dst_ofs, src + src_ofs, size) == dst + dst_ofs);
+  ref_move (ref + dst_ofs, src + src_ofs, size);
+  ASSERT (ref_compare (dst, ref, BUF_SIZE) == 0);
+
+  /* memset(). */
+  value = random_ulong () & 0xff;
+  ASSERT (memset (dst + dst_ofs, value, size) == dst + dst_ofs);
+  for (i = 0; i < size; i++)
+    ref[dst_ofs + i] = value;
+  ASSERT (ref_compare (dst, ref, BUF_SIZE) == 0);
+
+  /* memmove() within one buffer, in both directions. */
+  random_bytes (dst, BUF_SIZE);
+  memcpy (ref, dst, BUF_SIZE);
+  ASSERT (memmove (dst + dst_ofs, dst + src_ofs, size) == dst + dst_ofs);
+  ref_move (ref + dst_ofs, ref + src_ofs, size);
+  ASSERT (ref_compare (dst, ref, BUF_SIZE) == 0);
+  ASSERT (memmove (dst + src_ofs, dst + dst_ofs, size) == dst + src_ofs);
+  ref_move (ref + src_ofs, ref + dst_ofs, size);
+  ASSERT (ref_compare (dst, ref, BUF_SIZE) == 0);
+
+  /* memcmp(), with equal blocks and with one byte changed. */
+  memcpy (dst + dst_ofs, src + src_ofs, size);
+  ASSERT (memcmp (dst + dst_ofs, src + src_ofs, size) == 0);
+  if (size > 0)
+    {
+      dst[dst_ofs + random_ulong () % size] ^= 1 << random_ulong () % 8;
+      ASSERT (sign (memcmp (dst + dst_ofs, src + src_ofs, size))
+              == ref_compare (dst + dst_ofs, src + src_ofs, size));
+    }
+
+  /* strlen(). */
+  memset (dst, 'x', BUF_SIZE);
+  dst[dst_ofs + size] = '\0';
+  ASSERT (strlen ((char *) dst + dst_ofs) == size);
+}
+
+/* Copies SIZE bytes from SRC to DST a byte at a time, correctly
+   even if they overlap. */
+static void
+ref_move (uint8_t *dst, const uint8_t *src, size_t size) 
+{
+  size_t i;
+
+  if (dst < src)
+    for (i = 0; i < size; i++)
+      dst[i] = src[i];
+  else
+    for (i = size; i-- > 0; )
+      dst[i] = src[i];
+}
+
+/* Compares SIZE bytes at A and B a byte at a time, returning 1,
+   0, or -1. */
+static int
+ref_compare (const uint8_t *a, const uint8_t *b, size_t size) 
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (a[i] != b[i])
+      return a[i] > b[i] ? 1 : -1;
+  return 0;
+}
+
+/* Returns 1, 0, or -1 according to the sign of X. */
+static int
+sign (int x) 
+{
+  return (x > 0) - (x < 0);
+}
+
+/* Prints the time taken to run each function TIMING_ITERATIONS
+   times on a page. */
+static void
+time_functions (void) 
+{
+  static uint8_t a[PGSIZE], b[PGSIZE];
+  int64_t start;
+  int i;
+
+  memset (a, 'x', PGSIZE - 1);
+  a[PGSIZE - 1] = '\0';
+
+  start = timer_ticks ();
+  for (i = 0; i < TIMING_ITERATIONS; i++)
+    memcpy (b, a, PGSIZE);
+  printf ("memcpy: %"PRId64" ticks\n", timer_elapsed (start));
+
+  start = timer_ticks ();
+  for (i = 0; i < TIMING_ITERATIONS; i++)
+    memmove (b + 1, b, PGSIZE - 1);
+  printf ("memmove: %"PRId64" ticks\n", timer_elapsed (start));
+
+  start = timer_ticks ();
+  for (i = 0; i < TIMING_ITERATIONS; i++)
+    memset (b, i, PGSIZE);
+  printf ("memset: %"PRId64" ticks\n", timer_elapsed (start));
+
+  memcpy (b, a, PGSIZE);
+  start = timer_ticks ();
+  for (i = 0; i < TIMING_ITERATIONS; i++)
+    ASSERT (memcmp (a, b, PGSIZE) == 0);
+  printf ("memcmp: %"PRId64" ticks\n", timer_elapsed (start));
+
+  start = timer_ticks ();
+  for (i = 0; i < TIMING_ITERATIONS; i++)
+    ASSERT (strlen ((char *) a) == PGSIZE - 1);
+  printf ("strlen: %"PRId64" ticks\n", timer_elapsed (start));
+}
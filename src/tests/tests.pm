@@ -152,6 +152,21 @@ sub get_core_output {
     return @output[$start...$end];
 }
 
+# Returns @OUTPUT with the figure in each line that matches
+# PATTERN, the last group that PATTERN captures, replaced by "#".
+# Performance tests report figures, such as cycle counts, that
+# vary from run to run, so this shows the lines that hold them and
+# then leaves the figures out of the comparison.
+sub mask_figures {
+    my ($pattern, @output) = @_;
+    foreach (@output) {
+	next if !/$pattern/;
+	print "$_\n";
+	substr ($_, $-[$#-], $+[$#-] - $-[$#-]) = '#';
+    }
+    return @output;
+}
+
 sub compare_output {
     my ($run) = shift @_;
     my ($expected) = pop @_;
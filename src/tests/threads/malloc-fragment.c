@@ -0,0 +1,55 @@
+/* Fragments the kernel pool by allocating every free page and
+   then freeing every other one, so that no two free pages are
+   physically adjacent.  A multi-page malloc() must still
+   succeed, because large blocks need only be virtually
+   contiguous. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Maximum number of pages the test can track. */
+#define MAX_PAGES 4096
+
+/* Size of the large block, in bytes. */
+#define BIG_SIZE (8 * PGSIZE)
+
+void
+test_malloc_fragment (void) 
+{
+  static void *pages[MAX_PAGES];
+  size_t page_cnt, i;
+  uint8_t *big;
+
+  for (page_cnt = 0; page_cnt < MAX_PAGES; page_cnt++)
+    {
+      pages[page_cnt] = palloc_get_page (0);
+      if (pages[page_cnt] == NULL)
+        break;
+    }
+  if (page_cnt == MAX_PAGES)
+    fail ("kernel pool has more than %d pages", MAX_PAGES);
+  for (i = 0; i < page_cnt; i += 2)
+    palloc_free_page (pages[i]);
+  msg ("Freed every other page of the kernel pool.");
+
+  if (palloc_get_multiple (0, 2) != NULL)
+    fail ("found two physically contiguous free pages");
+
+  big = malloc (BIG_SIZE);
+  if (big == NULL)
+    fail ("malloc of %d bytes failed", BIG_SIZE);
+  memset (big, 0x5a, BIG_SIZE);
+  for (i = 0; i < BIG_SIZE; i++)
+    if (big[i] != 0x5a)
+      fail ("byte %zu of large block is %d", i, big[i]);
+  free (big);
+  msg ("Allocated and freed a block of %d pages.", BIG_SIZE / PGSIZE);
+
+  for (i = 1; i < page_cnt; i += 2)
+    palloc_free_page (pages[i]);
+}
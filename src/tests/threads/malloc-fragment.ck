@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(malloc-fragment) begin
+(malloc-fragment) Freed every other page of the kernel pool.
+(malloc-fragment) Allocated and freed a block of 8 pages.
+(malloc-fragment) end
+EOF
+pass;
@@ -0,0 +1,162 @@
+/* Repeatedly allocates and frees a mix of single and multi-page
+   blocks while keeping a window of them live, first in an
+   unfragmented kernel pool and then after fragmenting it by
+   allocating a run of single pages and freeing every other one.
+   Reports the cycles spent in the page allocator per allocation
+   in each case and fails if fragmentation makes allocation much
+   slower, as it does with a first-fit scan that has to step over
+   every hole.  Also checks that every block is writable and keeps
+   its contents, and that freeing everything leaves a large zeroed
+   block available again. */
+
+#include <inttypes.h>
+#include <rdtsc.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Number of single pages used to fragment the pool. */
+#define FRAG_PAGES 192
+
+/* Number of blocks kept allocated at once. */
+#define LIVE_CNT 16
+
+/* Number of blocks allocated in each workload. */
+#define ROUNDS 4000
+
+/* Fragmented allocation may take at most MAX_SLOWDOWN_NUM /
+   MAX_SLOWDOWN_DEN times as many cycles as unfragmented.  A
+   first-fit scan from the bottom of the pool steps over all
+   FRAG_PAGES fragmenting pages for each multi-page request,
+   several times more than it needs to in an unfragmented pool. */
+#define MAX_SLOWDOWN_NUM 3
+#define MAX_SLOWDOWN_DEN 2
+
+/* Size of the contiguous block allocated at the end. */
+#define BIG_PAGES 64
+
+struct block
+  {
+    uint32_t *pages;            /* First page, or null. */
+    size_t page_cnt;            /* Number of pages. */
+    uint32_t tag;               /* Value stored in each page. */
+  };
+
+/* Cycles spent in palloc_get_multiple() and
+   palloc_free_multiple() since last reset. */
+static uint64_t palloc_cycles;
+
+static uint64_t run_mix (void);
+static void fill (struct block *);
+static void check_and_free (struct block *);
+
+void
+test_palloc_fragment (void) 
+{
+  static struct block frag[FRAG_PAGES];
+  uint64_t plain, fragmented;
+  uint8_t *big;
+  int i;
+
+  plain = run_mix ();
+  msg ("%"PRIu64" cycles per allocation in an unfragmented pool", plain);
+
+  for (i = 0; i < FRAG_PAGES; i++)
+    {
+      frag[i].pages = palloc_get_page (0);
+      if (frag[i].pages == NULL)
+        fail ("could not allocate fragmenting page %d", i);
+      frag[i].page_cnt = 1;
+      frag[i].tag = 0x10000 + i;
+      fill (&frag[i]);
+    }
+  for (i = 0; i < FRAG_PAGES; i += 2)
+    check_and_free (&frag[i]);
+
+  fragmented = run_mix ();
+  msg ("%"PRIu64" cycles per allocation in a fragmented pool", fragmented);
+  if (fragmented * MAX_SLOWDOWN_DEN > plain * MAX_SLOWDOWN_NUM)
+    fail ("fragmentation slowed allocation from %"PRIu64" to %"PRIu64
+          " cycles", plain, fragmented);
+
+  for (i = 1; i < FRAG_PAGES; i += 2)
+    check_and_free (&frag[i]);
+
+  big = palloc_get_multiple (PAL_ZERO, BIG_PAGES);
+  if (big == NULL)
+    fail ("could not allocate %d contiguous pages", BIG_PAGES);
+  for (i = 0; i < BIG_PAGES * PGSIZE; i++)
+    if (big[i] != 0)
+      fail ("byte %d of zeroed block is %d", i, big[i]);
+  palloc_free_multiple (big, BIG_PAGES);
+  msg ("Allocated %d contiguous zeroed pages after freeing.", BIG_PAGES);
+}
+
+/* Allocates ROUNDS blocks of mixed sizes, keeping the last
+   LIVE_CNT of them allocated, then frees them all.  Returns the
+   average number of cycles spent in the page allocator per
+   allocation, counting the matching free. */
+static uint64_t
+run_mix (void) 
+{
+  static const size_t sizes[] = {1, 3, 2, 5, 1, 8, 4, 1, 2, 16, 1, 7};
+  static struct block live[LIVE_CNT];
+  uint64_t start;
+  int i;
+
+  palloc_cycles = 0;
+  for (i = 0; i < ROUNDS; i++)
+    {
+      struct block *b = &live[i % LIVE_CNT];
+
+      if (b->pages != NULL)
+        check_and_free (b);
+      b->page_cnt = sizes[i % (sizeof sizes / sizeof *sizes)];
+      start = rdtsc ();
+      b->pages = palloc_get_multiple (0, b->page_cnt);
+      palloc_cycles += rdtsc () - start;
+      if (b->pages == NULL)
+        fail ("could not allocate %zu pages in round %d", b->page_cnt, i);
+      b->tag = 0x20000 + i;
+      fill (b);
+    }
+  for (i = 0; i < LIVE_CNT; i++)
+    check_and_free (&live[i]);
+
+  return palloc_cycles / ROUNDS;
+}
+
+/* Stores B's tag at the start and end of each of its pages. */
+static void
+fill (struct block *b) 
+{
+  size_t i;
+
+  for (i = 0; i < b->page_cnt; i++)
+    {
+      uint32_t *page = b->pages + i * (PGSIZE / sizeof *page);
+      page[0] = page[PGSIZE / sizeof *page - 1] = b->tag;
+    }
+}
+
+/* Checks that B's pages still hold its tag, then frees them. */
+static void
+check_and_free (struct block *b) 
+{
+  uint64_t start;
+  size_t i;
+
+  for (i = 0; i < b->page_cnt; i++)
+    {
+      uint32_t *page = b->pages + i * (PGSIZE / sizeof *page);
+      if (page[0] != b->tag || page[PGSIZE / sizeof *page - 1] != b->tag)
+        fail ("page %zu of block tagged %"PRIx32" was overwritten",
+              i, b->tag);
+    }
+  start = rdtsc ();
+  palloc_free_multiple (b->pages, b->page_cnt);
+  palloc_cycles += rdtsc () - start;
+  b->pages = NULL;
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = mask_figures
+  (qr/^\(palloc-fragment\) (\d+) cycles per allocation in an? \w+ pool$/,
+   @output);
+compare_output ("run", \@output, [<<'EOF']);
+(palloc-fragment) begin
+(palloc-fragment) # cycles per allocation in an unfragmented pool
+(palloc-fragment) # cycles per allocation in a fragmented pool
+(palloc-fragment) Allocated 64 contiguous zeroed pages after freeing.
+(palloc-fragment) end
+EOF
+pass;
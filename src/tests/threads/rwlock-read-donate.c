@@ -0,0 +1,51 @@
+/* The main thread acquires a reader-writer lock for reading.
+   Then it creates a higher-priority writer, which waits for the
+   main thread to leave and so donates its priority to it, and a
+   second writer of higher priority still, which waits behind the
+   first and donates through it to the main thread.  When the main
+   thread releases the lock, both writers should finish, the
+   second first, before the main thread runs again. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread_func;
+
+void
+test_rwlock_read_donate (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_acquire_read (&rw);
+  thread_create ("writer 1", PRI_DEFAULT + 5, writer_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 5, thread_get_priority ());
+  thread_create ("writer 2", PRI_DEFAULT + 8, writer_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 8, thread_get_priority ());
+  rwlock_release_read (&rw);
+  msg ("writer 1, writer 2 must already have finished.");
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_write (rw);
+  msg ("%s: got the lock", thread_name ());
+  rwlock_release_write (rw);
+  msg ("%s: done", thread_name ());
+}
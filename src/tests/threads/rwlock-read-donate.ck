@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-read-donate) begin
+(rwlock-read-donate) This thread should have priority 36.  Actual priority: 36.
+(rwlock-read-donate) This thread should have priority 39.  Actual priority: 39.
+(rwlock-read-donate) writer 1: got the lock
+(rwlock-read-donate) writer 2: got the lock
+(rwlock-read-donate) writer 2: done
+(rwlock-read-donate) writer 1: done
+(rwlock-read-donate) writer 1, writer 2 must already have finished.
+(rwlock-read-donate) This thread should have priority 31.  Actual priority: 31.
+(rwlock-read-donate) end
+EOF
+pass;
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-writer-pref) begin
+(rwlock-writer-pref) Writer and reader should both be waiting.
+(rwlock-writer-pref) writer: got the lock
+(rwlock-writer-pref) reader: got the lock
+(rwlock-writer-pref) reader: done
+(rwlock-writer-pref) writer: done
+(rwlock-writer-pref) writer, reader must already have finished, in that order.
+(rwlock-writer-pref) This should be the last line before finishing this test.
+(rwlock-writer-pref) end
+EOF
+pass;
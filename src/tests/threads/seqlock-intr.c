@@ -0,0 +1,83 @@
+/* Races a sequence lock writer in the timer interrupt handler
+   against a reader thread.
+
+   On every tick the interrupt handler updates a two-word record
+   whose words must always be equal.  Meanwhile the main thread
+   reads the record over and over, pausing between the two words
+   so that ticks often land part-way through a read.  Every read
+   that seqlock_read_retry() accepts must see equal words, and at
+   least one read must have been retried. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Number of updates made by the interrupt handler. */
+#define WRITE_CNT 20
+
+/* Microseconds the reader waits between the two words. */
+#define READ_DELAY 1000
+
+struct record
+  {
+    struct seqlock sl;          /* Protects `first' and `second'. */
+    unsigned first;             /* Always equal to `second'. */
+    unsigned second;            /* Always equal to `first'. */
+    volatile int write_cnt;     /* Number of updates so far. */
+  };
+
+static timer_tick_hook_func write_record;
+
+void
+test_seqlock_intr (void) 
+{
+  static struct record rec;
+  int retries = 0;
+
+  seqlock_init (&rec.sl);
+  rec.first = rec.second = 0;
+  rec.write_cnt = 0;
+  timer_set_tick_hook (write_record, &rec);
+
+  while (rec.write_cnt < WRITE_CNT)
+    {
+      unsigned seq, first, second;
+
+      seq = seqlock_read_begin (&rec.sl);
+      first = rec.first;
+      timer_udelay (READ_DELAY);
+      second = rec.second;
+      if (seqlock_read_retry (&rec.sl, seq))
+        retries++;
+      else if (first != second)
+        fail ("read accepted torn record %u, %u", first, second);
+    }
+  timer_set_tick_hook (NULL, NULL);
+
+  msg ("Interrupt handler updated the record %d times.", WRITE_CNT);
+  if (retries == 0)
+    fail ("no read overlapped an update");
+  msg ("Every read that overlapped an update was retried.");
+}
+
+/* Timer tick hook.  Updates record REC_ until it has done so
+   WRITE_CNT times. */
+static void
+write_record (void *rec_) 
+{
+  struct record *rec = rec_;
+
+  ASSERT (intr_context ());
+
+  if (rec->write_cnt >= WRITE_CNT)
+    return;
+  seqlock_write_begin (&rec->sl);
+  rec->first++;
+  rec->second = rec->first;
+  seqlock_write_end (&rec->sl);
+  rec->write_cnt++;
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(seqlock-intr) begin
+(seqlock-intr) Interrupt handler updated the record 20 times.
+(seqlock-intr) Every read that overlapped an update was retried.
+(seqlock-intr) end
+EOF
+pass;
@@ -0,0 +1,89 @@
+/* Exercises a sequence lock with a lower-priority writer.
+
+   First the main thread reads while no write is in progress,
+   which must succeed without a retry.  Then a write that
+   completes between the start and end of a read must force the
+   reader to retry, and the retry must see the new value.  See
+   seqlock-intr.c for writes from an interrupt handler. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct seqlock_data
+  {
+    struct seqlock sl;          /* Protects `value'. */
+    int value;                  /* Value being read and written. */
+    struct semaphore go;        /* Upped to start the write. */
+    struct semaphore done;      /* Upped after the write. */
+  };
+
+static thread_func writer_thread_func;
+static int read_value (struct seqlock_data *, int *retries);
+
+void
+test_seqlock (void) 
+{
+  struct seqlock_data data;
+  unsigned seq;
+  int retries;
+  int value;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  seqlock_init (&data.sl);
+  data.value = 0;
+  sema_init (&data.go, 0);
+  sema_init (&data.done, 0);
+  thread_create ("writer", PRI_DEFAULT - 1, writer_thread_func, &data);
+
+  value = read_value (&data, &retries);
+  msg ("Read %d with %d retries.", value, retries);
+
+  seq = seqlock_read_begin (&data.sl);
+  value = data.value;
+  sema_up (&data.go);
+  sema_down (&data.done);
+  if (!seqlock_read_retry (&data.sl, seq))
+    fail ("read of %d overlapping a write was not retried", value);
+  value = read_value (&data, &retries);
+  msg ("Read %d with %d retries after an overlapping write.",
+       value, retries);
+}
+
+/* Reads DATA's value, storing the number of retries needed into
+   *RETRIES. */
+static int
+read_value (struct seqlock_data *data, int *retries) 
+{
+  unsigned seq;
+  int value;
+
+  *retries = 0;
+  for (;;)
+    {
+      seq = seqlock_read_begin (&data->sl);
+      value = data->value;
+      if (!seqlock_read_retry (&data->sl, seq))
+        return value;
+      ++*retries;
+    }
+}
+
+static void
+writer_thread_func (void *data_) 
+{
+  struct seqlock_data *data = data_;
+
+  sema_down (&data->go);
+  seqlock_write_begin (&data->sl);
+  data->value = 1;
+  seqlock_write_end (&data->sl);
+  sema_up (&data->done);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(seqlock) begin
+(seqlock) Read 0 with 0 retries.
+(seqlock) Read 1 with 0 retries after an overlapping write.
+(seqlock) end
+EOF
+pass;
@@ -1,11 +1,11 @@
 /* Child process run by multi-child-fd test.
 
    Attempts to close the file descriptor passed as the first
-   command-line argument.  This is invalid, because file
-   descriptors are not inherited in PintOS.  Two results are
-   allowed: either the system call should return without taking
-   any action, or the kernel should terminate the process with a
-   -1 exit code. */
+   command-line argument.  The child holds its own copy of the
+   descriptor, inherited from the parent, so this must not close
+   the parent's.  Two results are allowed: either the system call
+   should return, or the kernel should terminate the process with
+   a -1 exit code. */
 
 #include <ctype.h>
 #include <stdio.h>
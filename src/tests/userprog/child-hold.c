@@ -0,0 +1,27 @@
+/* Child process run by exec-latency test.
+
+   Closes the write end of the pipe whose descriptors are passed
+   as the command-line arguments, then reads from the read end,
+   which blocks until the parent closes the write end too.  So the
+   child stays alive until the parent lets it go. */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-hold";
+
+int
+main (int argc, char *argv[])
+{
+  char c;
+
+  quiet = true;
+  if (argc != 3 || !isdigit (*argv[1]) || !isdigit (*argv[2]))
+    fail ("bad command-line arguments");
+  close (atoi (argv[2]));
+  if (read (atoi (argv[1]), &c, 1) != 0)
+    fail ("read data from an empty pipe");
+  return 0;
+}
@@ -0,0 +1,38 @@
+/* Child process run by pipe-stream test.
+
+   Closes the read end of the pipe whose descriptors are passed as
+   the command-line arguments, then writes the stream that the
+   parent checks, of the length given by pipe-stream.h, to the
+   write end. */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/userprog/pipe-stream.h"
+
+const char *test_name = "child-pipe";
+
+int
+main (int argc, char *argv[])
+{
+  static char buf[STREAM_CHUNK];
+  int read_fd, write_fd;
+  size_t pos, i;
+
+  quiet = true;
+  if (argc != 3 || !isdigit (*argv[1]) || !isdigit (*argv[2]))
+    fail ("bad command-line arguments");
+  read_fd = atoi (argv[1]);
+  write_fd = atoi (argv[2]);
+  close (read_fd);
+
+  for (pos = 0; pos < STREAM_SIZE; pos += STREAM_CHUNK)
+    {
+      for (i = 0; i < STREAM_CHUNK; i++)
+        buf[i] = STREAM_BYTE (pos + i);
+      if (write (write_fd, buf, STREAM_CHUNK) != STREAM_CHUNK)
+        fail ("write failed at byte %zu", pos);
+    }
+  return 0;
+}
@@ -0,0 +1,66 @@
+/* Copies a 64 kB file twice, first by reading and writing it
+   through a 1 kB user buffer, as examples/cp once did, then with
+   copy_file_range(), and reports the cost of each in CPU cycles
+   per kB copied.  Checks both copies. */
+
+#include <rdtsc.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (64 * 1024)
+
+static char buf[SIZE];
+
+/* Creates and opens FILE_NAME, SIZE bytes long. */
+static int
+create_file (const char *file_name)
+{
+  int fd;
+
+  CHECK (create (file_name, SIZE), "create \"%s\"", file_name);
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  return fd;
+}
+
+void
+test_main (void)
+{
+  int src_fd, loop_fd, copy_fd;
+  uint64_t start;
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    buf[i] = i % 251;
+  src_fd = create_file ("src");
+  CHECK (write (src_fd, buf, SIZE) == SIZE, "write \"src\"");
+  loop_fd = create_file ("loop");
+  copy_fd = create_file ("copy");
+
+  msg ("copy with read and write");
+  seek (src_fd, 0);
+  start = rdtsc ();
+  for (;;)
+    {
+      char chunk[1024];
+      int bytes_read = read (src_fd, chunk, sizeof chunk);
+      if (bytes_read == 0)
+        break;
+      if (write (loop_fd, chunk, bytes_read) != bytes_read)
+        fail ("write failed");
+    }
+  msg ("%llu cycles per kB",
+       (unsigned long long) ((rdtsc () - start) / (SIZE / 1024)));
+
+  msg ("copy with copy_file_range");
+  seek (src_fd, 0);
+  start = rdtsc ();
+  if (copy_file_range (src_fd, copy_fd, SIZE) != SIZE)
+    fail ("copy_file_range failed");
+  msg ("%llu cycles per kB",
+       (unsigned long long) ((rdtsc () - start) / (SIZE / 1024)));
+
+  check_file ("loop", buf, SIZE);
+  check_file ("copy", buf, SIZE);
+}
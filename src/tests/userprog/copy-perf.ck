@@ -0,0 +1,33 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = mask_figures (qr/^\(copy-perf\) (\d+) cycles per kB$/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(copy-perf) begin
+(copy-perf) create "src"
+(copy-perf) open "src"
+(copy-perf) write "src"
+(copy-perf) create "loop"
+(copy-perf) open "loop"
+(copy-perf) create "copy"
+(copy-perf) open "copy"
+(copy-perf) copy with read and write
+(copy-perf) # cycles per kB
+(copy-perf) copy with copy_file_range
+(copy-perf) # cycles per kB
+(copy-perf) open "loop" for verification
+(copy-perf) verified contents of "loop"
+(copy-perf) close "loop"
+(copy-perf) open "copy" for verification
+(copy-perf) verified contents of "copy"
+(copy-perf) close "copy"
+(copy-perf) end
+copy-perf: exit(0)
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Copies parts of one file into another with copy_file_range(),
+   at offsets that fall in the middle of sectors, and checks the
+   result, the file positions, and some calls that must fail. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE 2000
+#define SRC_OFS 100
+#define DST_OFS 300
+#define COPY_SIZE 1500
+
+static char src[SIZE];
+static char dst[SIZE];
+
+void
+test_main (void) 
+{
+  int src_fd, dst_fd;
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    src[i] = i % 251;
+
+  CHECK (create ("src", SIZE), "create \"src\"");
+  CHECK ((src_fd = open ("src")) > 1, "open \"src\"");
+  CHECK (write (src_fd, src, SIZE) == SIZE, "write \"src\"");
+  CHECK (create ("dst", SIZE), "create \"dst\"");
+  CHECK ((dst_fd = open ("dst")) > 1, "open \"dst\"");
+
+  seek (src_fd, SRC_OFS);
+  seek (dst_fd, DST_OFS);
+  CHECK (copy_file_range (src_fd, dst_fd, COPY_SIZE) == COPY_SIZE,
+         "copy %d bytes", COPY_SIZE);
+  CHECK (tell (src_fd) == SRC_OFS + COPY_SIZE
+         && tell (dst_fd) == DST_OFS + COPY_SIZE, "positions advanced");
+  CHECK (copy_file_range (src_fd, dst_fd, SIZE) == SIZE - DST_OFS - COPY_SIZE,
+         "copy stops at end of \"dst\"");
+  CHECK (copy_file_range (src_fd, dst_fd, SIZE) == 0, "copy at end of file");
+
+  memset (dst, 0, sizeof dst);
+  memcpy (dst + DST_OFS, src + SRC_OFS, SIZE - DST_OFS);
+  check_file ("dst", dst, SIZE);
+
+  CHECK (copy_file_range (src_fd, 1234, 10) == -1, "copy to bad fd");
+  seek (src_fd, 0);
+  seek (dst_fd, 0);
+  CHECK (copy_file_range (src_fd, src_fd, 10) == -1, "copy onto itself");
+}
@@ -0,0 +1,24 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range) begin
+(copy-range) create "src"
+(copy-range) open "src"
+(copy-range) write "src"
+(copy-range) create "dst"
+(copy-range) open "dst"
+(copy-range) copy 1500 bytes
+(copy-range) positions advanced
+(copy-range) copy stops at end of "dst"
+(copy-range) copy at end of file
+(copy-range) open "dst" for verification
+(copy-range) verified contents of "dst"
+(copy-range) close "dst"
+(copy-range) copy to bad fd
+(copy-range) copy onto itself
+(copy-range) end
+copy-range: exit(0)
+EOF
+pass;
@@ -0,0 +1,75 @@
+/* Times exec as the number of live processes grows.  Starts
+   batches of child-hold processes, which stay alive, blocked on a
+   pipe, until this process closes the pipe's write end.  Before
+   each batch, and after the last, times a few execs of
+   child-simple and reports the average cost of an exec in CPU
+   cycles, so that comparing the figures shows whether exec
+   latency depends on how many processes are alive. */
+
+#include <rdtsc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Number of child-hold processes started in each batch. */
+#define BATCH 100
+
+/* Number of batches. */
+#define BATCH_CNT 4
+
+/* Number of child-simple execs timed before each batch. */
+#define SAMPLE_CNT 8
+
+/* Times SAMPLE_CNT execs of child-simple and reports their
+   average cost with LIVE child-hold processes alive. */
+static void
+time_execs (int live)
+{
+  uint64_t cycles = 0;
+  int i;
+
+  for (i = 0; i < SAMPLE_CNT; i++)
+    {
+      uint64_t start = rdtsc ();
+      pid_t pid = exec ("child-simple");
+      int code;
+
+      cycles += rdtsc () - start;
+      code = wait (pid);
+      if (code != 81)
+        fail ("wait(exec(\"child-simple\")) returned %d", code);
+    }
+  msg ("%d waiting children: %llu cycles per exec", live,
+       (unsigned long long) (cycles / SAMPLE_CNT));
+}
+
+void
+test_main (void)
+{
+  static pid_t holders[BATCH * BATCH_CNT];
+  char child_cmd[128];
+  int fds[2];
+  int live = 0;
+  int batch, i;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  snprintf (child_cmd, sizeof child_cmd, "child-hold %d %d", fds[0], fds[1]);
+  for (batch = 0; batch < BATCH_CNT; batch++)
+    {
+      time_execs (live);
+      msg ("start %d waiting children", BATCH);
+      for (i = 0; i < BATCH; i++, live++)
+        if ((holders[live] = exec (child_cmd)) == -1)
+          fail ("exec child-hold %d failed", live);
+    }
+  time_execs (live);
+
+  msg ("release waiting children");
+  close (fds[1]);
+  for (i = 0; i < live; i++)
+    if (wait (holders[i]) != 0)
+      fail ("child-hold %d did not exit(0)", i);
+  close (fds[0]);
+}
@@ -0,0 +1,29 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my ($batch) = 100;
+my ($batch_cnt) = 4;
+my ($samples) = 8;
+my ($expected) = "(exec-latency) begin\n(exec-latency) pipe\n";
+for (my ($i) = 0; $i <= $batch_cnt; $i++) {
+    $expected .= "(child-simple) run\nchild-simple: exit(81)\n" x $samples;
+    $expected .= "(exec-latency) " . $i * $batch
+      . " waiting children: # cycles per exec\n";
+    $expected .= "(exec-latency) start $batch waiting children\n"
+      if $i < $batch_cnt;
+}
+$expected .= "(exec-latency) release waiting children\n";
+$expected .= "child-hold: exit(0)\n" x ($batch * $batch_cnt);
+$expected .= "(exec-latency) end\nexec-latency: exit(0)\n";
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = mask_figures
+  (qr/^\(exec-latency\) \d+ waiting children: (\d+) cycles per exec$/,
+   @output);
+compare_output ("run", \@output, [$expected]);
+pass;
@@ -1,7 +1,8 @@
 /* Opens a file and then runs a subprocess that tries to close
-   the file.  (PintOS does not have inheritance of file handles,
-   so this must fail.)  The parent process then attempts to use
-   the file handle, which must succeed. */
+   the file.  (A child inherits copies of its parent's file
+   handles, so this can only close the child's copy.)  The parent
+   process then attempts to use the file handle, which must
+   succeed. */
 
 #include <stdio.h>
 #include <syscall.h>
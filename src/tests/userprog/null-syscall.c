@@ -0,0 +1,89 @@
+/* Times a system call that does no work, getpid, entered
+   through the "int $0x30" gate with its number on the stack,
+   through the "int $0x31" gate with its number in a register,
+   and, if the CPU has it, through SYSENTER, to compare the cost
+   of the ways into the kernel.  Reports the average cost of a
+   call in CPU cycles. */
+
+#include <rdtsc.h>
+#include <stdint.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+#include <sysenter.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CALL_CNT 100000
+
+/* Invokes getpid through "int $0x30". */
+static inline int
+getpid_stack (void)
+{
+  int retval;
+  asm volatile ("pushl %[number]; int $0x30; addl $4, %%esp"
+                : "=a" (retval)
+                : [number] "i" (SYS_GETPID)
+                : "memory");
+  return retval;
+}
+
+/* Invokes getpid through "int $0x31". */
+static inline int
+getpid_reg (void)
+{
+  int retval;
+  asm volatile ("int $0x31"
+                : "=a" (retval)
+                : "a" (SYS_GETPID)
+                : "memory");
+  return retval;
+}
+
+/* Invokes getpid through SYSENTER. */
+static inline int
+getpid_sysenter (void)
+{
+  int retval;
+  asm volatile ("pushl %%edx; pushl %%ecx; movl %%esp, %%ecx; "
+                "movl $1f, %%edx; sysenter; 1: addl $8, %%esp"
+                : "=a" (retval)
+                : "a" (SYS_GETPID)
+                : "ecx", "edx", "memory");
+  return retval;
+}
+
+/* Calls GETPID_FUNC CALL_CNT times and reports the cycles per call. */
+static void
+time_getpid (int (*getpid_func) (void), pid_t pid)
+{
+  uint64_t start, cycles;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < CALL_CNT; i++)
+    if (getpid_func () != pid)
+      fail ("getpid returned the wrong pid");
+  cycles = rdtsc () - start;
+  msg ("%llu cycles per call", (unsigned long long) (cycles / CALL_CNT));
+}
+
+void
+test_main (void)
+{
+  pid_t pid = getpid ();
+
+  msg ("getpid through int $0x30");
+  time_getpid (getpid_stack, pid);
+
+  msg ("getpid through int $0x31");
+  time_getpid (getpid_reg, pid);
+
+  if (!sysenter_supported ())
+    {
+      msg ("sysenter not supported");
+      return;
+    }
+
+  msg ("getpid through sysenter");
+  time_getpid (getpid_sysenter, pid);
+}
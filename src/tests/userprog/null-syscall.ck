@@ -0,0 +1,31 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = mask_figures (qr/^\(null-syscall\) (\d+) cycles per call$/, @output);
+compare_output ("run", \@output, [<<'EOF', <<'EOF']);
+(null-syscall) begin
+(null-syscall) getpid through int $0x30
+(null-syscall) # cycles per call
+(null-syscall) getpid through int $0x31
+(null-syscall) # cycles per call
+(null-syscall) getpid through sysenter
+(null-syscall) # cycles per call
+(null-syscall) end
+null-syscall: exit(0)
+EOF
+(null-syscall) begin
+(null-syscall) getpid through int $0x30
+(null-syscall) # cycles per call
+(null-syscall) getpid through int $0x31
+(null-syscall) # cycles per call
+(null-syscall) sysenter not supported
+(null-syscall) end
+null-syscall: exit(0)
+EOF
+pass;
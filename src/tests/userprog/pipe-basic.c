@@ -0,0 +1,34 @@
+/* Writes to a pipe and reads the bytes back in the same process.
+   Checks that the ends cannot be used the wrong way round, that
+   the read end reports end of file once the write end is closed,
+   and that writing fails once the read end is closed. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  int fds[2];
+  char buf[16];
+
+  CHECK (pipe (fds) == 0, "pipe");
+  CHECK (fds[0] > 1 && fds[1] > 1 && fds[0] != fds[1],
+         "two new descriptors");
+  CHECK (write (fds[1], "hello", 5) == 5, "write \"hello\"");
+  CHECK (read (fds[0], buf, sizeof buf) == 5 && !memcmp (buf, "hello", 5),
+         "read \"hello\"");
+  CHECK (read (fds[1], buf, sizeof buf) == -1, "read the write end");
+  CHECK (write (fds[0], "x", 1) == -1, "write the read end");
+  CHECK (pread (fds[0], buf, sizeof buf, 0) == -1, "pread the read end");
+  close (fds[1]);
+  CHECK (read (fds[0], buf, sizeof buf) == 0, "read at end of file");
+  close (fds[0]);
+
+  CHECK (pipe (fds) == 0, "pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], "x", 1) == -1, "write with no reader");
+  close (fds[1]);
+}
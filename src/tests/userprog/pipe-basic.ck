@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-basic) begin
+(pipe-basic) pipe
+(pipe-basic) two new descriptors
+(pipe-basic) write "hello"
+(pipe-basic) read "hello"
+(pipe-basic) read the write end
+(pipe-basic) write the read end
+(pipe-basic) pread the read end
+(pipe-basic) read at end of file
+(pipe-basic) pipe
+(pipe-basic) write with no reader
+(pipe-basic) end
+pipe-basic: exit(0)
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Streams 32 MB through a pipe from a child process, which
+   inherits the pipe's write end, and reports the cost in CPU
+   cycles per kB.  Checks every byte, and that the stream ends
+   when the child exits. */
+
+#include <rdtsc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/userprog/pipe-stream.h"
+
+void
+test_main (void)
+{
+  static char buf[STREAM_CHUNK];
+  char child_cmd[128];
+  int fds[2];
+  pid_t child;
+  size_t pos = 0;
+  uint64_t start;
+
+  CHECK (pipe (fds) == 0, "pipe");
+  snprintf (child_cmd, sizeof child_cmd, "child-pipe %d %d", fds[0], fds[1]);
+  CHECK ((child = exec (child_cmd)) != -1, "exec child-pipe");
+  close (fds[1]);
+
+  start = rdtsc ();
+  for (;;)
+    {
+      int bytes_read = read (fds[0], buf, sizeof buf);
+      int i;
+
+      if (bytes_read == 0)
+        break;
+      if (bytes_read < 0)
+        fail ("read failed at byte %zu", pos);
+      for (i = 0; i < bytes_read; i++, pos++)
+        if (buf[i] != STREAM_BYTE (pos))
+          fail ("byte %zu differs", pos);
+    }
+  msg ("%llu cycles per kB",
+       (unsigned long long) ((rdtsc () - start) / (STREAM_SIZE / 1024)));
+
+  if (pos != STREAM_SIZE)
+    fail ("read %zu bytes, expected %d", pos, STREAM_SIZE);
+  msg ("read %d bytes", STREAM_SIZE);
+  close (fds[0]);
+  CHECK (wait (child) == 0, "wait for child-pipe");
+}
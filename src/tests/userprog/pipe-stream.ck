@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+# The child's exit message can come before or after the parent's
+# lines, so it is checked separately.
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+fail "child-pipe did not exit(0)\n"
+  if !grep ($_ eq 'child-pipe: exit(0)', @output);
+@output = grep ($_ ne 'child-pipe: exit(0)', @output);
+@output = mask_figures (qr/^\(pipe-stream\) (\d+) cycles per kB$/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(pipe-stream) begin
+(pipe-stream) pipe
+(pipe-stream) exec child-pipe
+(pipe-stream) # cycles per kB
+(pipe-stream) read 33554432 bytes
+(pipe-stream) wait for child-pipe
+(pipe-stream) end
+pipe-stream: exit(0)
+EOF
+pass;
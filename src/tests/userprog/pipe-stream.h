@@ -0,0 +1,13 @@
+#ifndef TESTS_USERPROG_PIPE_STREAM_H
+#define TESTS_USERPROG_PIPE_STREAM_H
+
+/* Bytes that child-pipe streams to pipe-stream. */
+#define STREAM_SIZE (32 * 1024 * 1024)
+
+/* Bytes moved by each read and write. */
+#define STREAM_CHUNK 4096
+
+/* The byte at position POS in the stream. */
+#define STREAM_BYTE(POS) ((char) ((POS) % 251))
+
+#endif /* tests/userprog/pipe-stream.h */
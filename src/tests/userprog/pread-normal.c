@@ -0,0 +1,30 @@
+/* Reads "sample.txt" with pread() in pieces, last piece first,
+   and checks that the file position does not move. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PIECE 37
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample - 1];
+  int handle, ofs;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  for (ofs = (sizeof buf - 1) / PIECE * PIECE; ofs >= 0; ofs -= PIECE)
+    {
+      int size = sizeof buf - ofs < PIECE ? (int) sizeof buf - ofs : PIECE;
+      int byte_cnt = pread (handle, buf + ofs, size, ofs);
+      if (byte_cnt != size)
+        fail ("pread() at %d returned %d instead of %d",
+              ofs, byte_cnt, size);
+    }
+  compare_bytes (buf, sample, sizeof buf, 0, "sample.txt");
+  CHECK (tell (handle) == 0, "file position still 0");
+  CHECK (pread (handle, buf, sizeof buf, sizeof buf) == 0,
+         "pread() at end of file");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-normal) begin
+(pread-normal) open "sample.txt"
+(pread-normal) file position still 0
+(pread-normal) pread() at end of file
+(pread-normal) end
+pread-normal: exit(0)
+EOF
+pass;
@@ -0,0 +1,31 @@
+/* Writes a file with pwrite() in pieces, last piece first, and
+   checks that the file position does not move and that the
+   file ends up with the right contents. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PIECE 37
+
+void
+test_main (void) 
+{
+  int handle, ofs;
+
+  CHECK (create ("test.txt", sizeof sample - 1), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  for (ofs = (sizeof sample - 2) / PIECE * PIECE; ofs >= 0; ofs -= PIECE)
+    {
+      int size = (int) sizeof sample - 1 - ofs < PIECE
+                 ? (int) sizeof sample - 1 - ofs : PIECE;
+      int byte_cnt = pwrite (handle, sample + ofs, size, ofs);
+      if (byte_cnt != size)
+        fail ("pwrite() at %d returned %d instead of %d",
+              ofs, byte_cnt, size);
+    }
+  CHECK (tell (handle) == 0, "file position still 0");
+  close (handle);
+  check_file ("test.txt", sample, sizeof sample - 1);
+}
@@ -0,0 +1,25 @@
+/* Reads "sample.txt" with one readv() into three buffers of
+   different sizes. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char a[10], b[100], c[sizeof sample - 1 - sizeof a - sizeof b];
+  struct iovec iov[] = {{a, sizeof a}, {b, sizeof b}, {c, sizeof c}};
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  byte_cnt = readv (handle, iov, 3);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("readv() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  compare_bytes (a, sample, sizeof a, 0, "sample.txt");
+  compare_bytes (b, sample + sizeof a, sizeof b, sizeof a, "sample.txt");
+  compare_bytes (c, sample + sizeof a + sizeof b, sizeof c,
+                 sizeof a + sizeof b, "sample.txt");
+  CHECK (readv (handle, iov, 3) == 0, "readv() at end of file");
+}
@@ -0,0 +1,62 @@
+/* Checks that ring_setup() turns away bad rings and that bad
+   operations complete with -1 without harming the process. */
+
+#include <syscall.h>
+#include <ring.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define RING ((void *) 0x10000000)
+
+/* Adds an operation to the submission queue. */
+static void
+queue (uint32_t op, int fd, void *buf, uint32_t len, uint32_t user_data)
+{
+  struct ring_sq *sq = RING_SQ (RING);
+  struct ring_sqe *sqe = &sq->sqes[sq->tail % RING_ENTRIES];
+
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->len = len;
+  sqe->offset = 0;
+  sqe->user_data = user_data;
+  sq->tail++;
+}
+
+void
+test_main (void) 
+{
+  struct ring_cq *cq = RING_CQ (RING);
+  char stack_buf[16];
+  int handle;
+  int i;
+
+  CHECK (!ring_setup ((char *) RING + 123, 1), "ring_setup unaligned");
+  CHECK (!ring_setup ((void *) 0x08048000, 1), "ring_setup over code");
+  CHECK (!ring_setup (RING, RING_BUF_MAX + 1), "ring_setup too big");
+  CHECK (ring_setup (RING, 1), "ring_setup");
+  CHECK (!ring_setup ((char *) RING + 0x100000, 1), "ring_setup again");
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  queue (RING_NOP, 0, NULL, 0, 0);
+  queue (RING_READ, handle, stack_buf, sizeof stack_buf, 1);
+  queue (RING_READ, handle + 100, RING_BUF (RING), 16, 2);
+  queue (RING_READ, handle, RING_BUF (RING) + 4000, 200, 3);
+  queue (RING_OPEN, 0, RING_BUF (RING), 100, 4);
+  queue (99, 0, NULL, 0, 5);
+  CHECK (ring_enter (6, 6) == 6, "ring_enter");
+
+  for (i = 0; i < 6; i++)
+    {
+      struct ring_cqe *cqe = &cq->cqes[cq->head % RING_ENTRIES];
+      int expect = cqe->user_data == 0 ? 0 : -1;
+      if (cq->head == cq->tail)
+        fail ("only %d completions", i);
+      if (cqe->result != expect)
+        fail ("operation %u returned %d instead of %d",
+              cqe->user_data, cqe->result, expect);
+      cq->head++;
+    }
+  msg ("bad operations failed");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-bad) begin
+(ring-bad) ring_setup unaligned
+(ring-bad) ring_setup over code
+(ring-bad) ring_setup too big
+(ring-bad) ring_setup
+(ring-bad) ring_setup again
+(ring-bad) open "sample.txt"
+(ring-bad) ring_enter
+(ring-bad) bad operations failed
+(ring-bad) end
+ring-bad: exit(0)
+EOF
+pass;
@@ -0,0 +1,110 @@
+/* Opens a file, writes it, reads it back and closes it through
+   an I/O ring, with several reads or writes in flight at once. */
+
+#include <string.h>
+#include <syscall.h>
+#include <ring.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define RING ((void *) 0x10000000)
+#define PIECE 64
+
+/* Adds an operation to the submission queue. */
+static void
+queue (uint32_t op, int fd, void *buf, uint32_t len, uint32_t offset,
+       uint32_t user_data)
+{
+  struct ring_sq *sq = RING_SQ (RING);
+  struct ring_sqe *sqe = &sq->sqes[sq->tail % RING_ENTRIES];
+
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->len = len;
+  sqe->offset = offset;
+  sqe->user_data = user_data;
+  sq->tail++;
+}
+
+/* Takes the next completion, which must be ready. */
+static struct ring_cqe
+reap (void)
+{
+  struct ring_cq *cq = RING_CQ (RING);
+  struct ring_cqe cqe;
+
+  if (cq->head == cq->tail)
+    fail ("no completion ready");
+  cqe = cq->cqes[cq->head % RING_ENTRIES];
+  cq->head++;
+  return cqe;
+}
+
+/* Submits the N queued operations and waits for them all. */
+static void
+enter (int n)
+{
+  int submitted = ring_enter (n, n);
+  if (submitted != n)
+    fail ("ring_enter() submitted %d of %d operations", submitted, n);
+}
+
+/* Queues a read or write of each PIECE of BUF, which holds the
+   sample, submits them, and checks their completions. */
+static void
+transfer (uint32_t op, int fd, char *buf)
+{
+  size_t size = sizeof sample - 1;
+  size_t ofs;
+  int n = 0;
+
+  for (ofs = 0; ofs < size; ofs += PIECE, n++)
+    queue (op, fd, buf + ofs, size - ofs < PIECE ? size - ofs : PIECE,
+           ofs, ofs);
+  enter (n);
+  while (n-- > 0)
+    {
+      struct ring_cqe cqe = reap ();
+      size_t expect = size - cqe.user_data < PIECE
+                      ? size - cqe.user_data : PIECE;
+      if (cqe.result != (int) expect)
+        fail ("operation at offset %u returned %d instead of %zu",
+              cqe.user_data, cqe.result, expect);
+    }
+}
+
+void
+test_main (void) 
+{
+  char *name = RING_BUF (RING);
+  char *out = name + 64;
+  char *in = out + sizeof sample;
+  struct ring_cqe cqe;
+  int fd;
+
+  CHECK (create ("test.txt", sizeof sample - 1), "create \"test.txt\"");
+  CHECK (ring_setup (RING, 1), "ring_setup");
+
+  strlcpy (name, "test.txt", 64);
+  queue (RING_OPEN, 0, name, strlen (name), 0, 0);
+  enter (1);
+  cqe = reap ();
+  fd = cqe.result;
+  CHECK (fd > 1, "open \"test.txt\" through ring");
+
+  memcpy (out, sample, sizeof sample - 1);
+  transfer (RING_WRITE, fd, out);
+  msg ("write \"test.txt\" through ring");
+
+  transfer (RING_READ, fd, in);
+  compare_bytes (in, sample, sizeof sample - 1, 0, "test.txt");
+  msg ("read \"test.txt\" through ring");
+
+  queue (RING_CLOSE, fd, NULL, 0, 0, 0);
+  enter (1);
+  CHECK (reap ().result == 0, "close \"test.txt\" through ring");
+
+  check_file ("test.txt", sample, sizeof sample - 1);
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-rw) begin
+(ring-rw) create "test.txt"
+(ring-rw) ring_setup
+(ring-rw) open "test.txt" through ring
+(ring-rw) write "test.txt" through ring
+(ring-rw) read "test.txt" through ring
+(ring-rw) close "test.txt" through ring
+(ring-rw) open "test.txt" for verification
+(ring-rw) verified contents of "test.txt"
+(ring-rw) close "test.txt"
+(ring-rw) end
+ring-rw: exit(0)
+EOF
+pass;
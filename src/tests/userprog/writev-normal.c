@@ -0,0 +1,27 @@
+/* Writes a file with one writev() from three buffers of
+   different sizes. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct iovec iov[] =
+    {
+      {sample, 10},
+      {sample + 10, 100},
+      {sample + 110, sizeof sample - 1 - 110},
+    };
+  int handle, byte_cnt;
+
+  CHECK (create ("test.txt", sizeof sample - 1), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+  byte_cnt = writev (handle, iov, 3);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("writev() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  close (handle);
+  check_file ("test.txt", sample, sizeof sample - 1);
+}
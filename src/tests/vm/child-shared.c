@@ -0,0 +1,22 @@
+/* Child process of mmap-shared.
+   Maps shared.dat shared and writes a message to it, then exits
+   without calling munmap. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x20000000)
+
+void
+test_main (void)
+{
+  static const char message[] = "written by child-shared";
+  int handle;
+
+  CHECK ((handle = open ("shared.dat")) > 1, "open \"shared.dat\"");
+  CHECK (mmap_range (ACTUAL, 4096, MAP_SHARED, handle, 0) != MAP_FAILED,
+         "mmap \"shared.dat\" shared");
+  memcpy (ACTUAL, message, sizeof message);
+}
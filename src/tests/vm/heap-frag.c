@@ -0,0 +1,67 @@
+/* Allocates blocks of many sizes, small and big, frees every
+   other one, and allocates blocks of other sizes in the holes,
+   checking that no block's contents are disturbed.  Then frees
+   everything and checks that the heap shrinks back to where it
+   started. */
+
+#include <malloc.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_CNT 512
+
+static char *blocks[BLOCK_CNT];
+static size_t sizes[BLOCK_CNT];
+
+/* Allocates block I with SIZE bytes and fills it with a pattern
+   of its own. */
+static void
+allocate (size_t i, size_t size)
+{
+  blocks[i] = malloc (size);
+  if (blocks[i] == NULL)
+    fail ("malloc of %zu bytes failed", size);
+  sizes[i] = size;
+  memset (blocks[i], i, size);
+}
+
+/* Checks that block I still holds its pattern. */
+static void
+check (size_t i)
+{
+  size_t j;
+
+  for (j = 0; j < sizes[i]; j++)
+    if (blocks[i][j] != (char) i)
+      fail ("block %zu byte %zu is %d", i, j, blocks[i][j]);
+}
+
+void
+test_main (void)
+{
+  char *start = sbrk (0);
+  size_t i;
+
+  msg ("allocate %d blocks", BLOCK_CNT);
+  for (i = 0; i < BLOCK_CNT; i++)
+    allocate (i, i * 37 % 3000 + 1);
+
+  msg ("free every other block");
+  for (i = 0; i < BLOCK_CNT; i += 2)
+    free (blocks[i]);
+
+  msg ("allocate other sizes in the holes");
+  for (i = 0; i < BLOCK_CNT; i += 2)
+    allocate (i, i * 53 % 1500 + 1);
+
+  msg ("check all blocks");
+  for (i = 0; i < BLOCK_CNT; i++)
+    check (i);
+
+  msg ("free all blocks");
+  for (i = 0; i < BLOCK_CNT; i++)
+    free (blocks[i]);
+  CHECK (sbrk (0) == start, "heap shrank back to its start");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(heap-frag) begin
+(heap-frag) allocate 512 blocks
+(heap-frag) free every other block
+(heap-frag) allocate other sizes in the holes
+(heap-frag) check all blocks
+(heap-frag) free all blocks
+(heap-frag) heap shrank back to its start
+(heap-frag) end
+EOF
+pass;
@@ -0,0 +1,67 @@
+/* Allocates big blocks of hundreds of kB, checks that calloc()
+   gives zeros and that realloc() keeps a block's contents as it
+   grows and shrinks, and that a request for more memory than the
+   heap can hold fails without harm.  Then frees everything and
+   checks that the heap shrinks back to where it started. */
+
+#include <malloc.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (512 * 1024)
+
+/* Fills the SIZE bytes at P with a pattern. */
+static void
+fill (char *p, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    p[i] = i % 251;
+}
+
+/* Checks that the SIZE bytes at P hold the pattern. */
+static void
+check (const char *p, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (p[i] != (char) (i % 251))
+      fail ("byte %zu is %d", i, p[i]);
+}
+
+void
+test_main (void)
+{
+  char *start = sbrk (0);
+  char *a, *b;
+  size_t i;
+
+  a = malloc (SIZE);
+  CHECK (a != NULL, "malloc %d bytes", SIZE);
+  fill (a, SIZE);
+
+  b = calloc (SIZE, 1);
+  CHECK (b != NULL, "calloc %d bytes", SIZE);
+  for (i = 0; i < SIZE; i++)
+    if (b[i] != 0)
+      fail ("byte %zu is %d", i, b[i]);
+
+  a = realloc (a, 2 * SIZE);
+  CHECK (a != NULL, "realloc to %d bytes", 2 * SIZE);
+  check (a, SIZE);
+  fill (a, 2 * SIZE);
+
+  a = realloc (a, SIZE / 4);
+  CHECK (a != NULL, "realloc to %d bytes", SIZE / 4);
+  check (a, SIZE / 4);
+
+  CHECK (malloc (0x7ff00000) == NULL, "malloc too much fails");
+
+  free (a);
+  free (b);
+  CHECK (sbrk (0) == start, "heap shrank back to its start");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(heap-large) begin
+(heap-large) malloc 524288 bytes
+(heap-large) calloc 524288 bytes
+(heap-large) realloc to 1048576 bytes
+(heap-large) realloc to 131072 bytes
+(heap-large) malloc too much fails
+(heap-large) heap shrank back to its start
+(heap-large) end
+EOF
+pass;
@@ -0,0 +1,35 @@
+/* Maps anonymous memory and checks that it reads as zeros and
+   keeps what is written to it, and that an empty mapping
+   fails. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+#define SIZE (16 * 4096)
+
+void
+test_main (void)
+{
+  mapid_t map;
+  size_t i;
+
+  CHECK ((map = mmap_range (ACTUAL, SIZE, MAP_ANON, -1, 0)) != MAP_FAILED,
+         "mmap anonymous memory");
+  for (i = 0; i < SIZE; i++)
+    if (ACTUAL[i] != 0)
+      fail ("byte %zu is %d, not zero", i, ACTUAL[i]);
+
+  msg ("write and read back");
+  for (i = 0; i < SIZE; i++)
+    ACTUAL[i] = i % 253;
+  for (i = 0; i < SIZE; i++)
+    if (ACTUAL[i] != (char) (i % 253))
+      fail ("byte %zu is %d", i, ACTUAL[i]);
+
+  munmap (map);
+  CHECK (mmap_range (ACTUAL, 0, MAP_ANON, -1, 0) == MAP_FAILED,
+         "mmap of zero bytes fails");
+}
@@ -0,0 +1,66 @@
+/* Reads a file mapping in order after MADV_SEQUENTIAL, and again
+   after MADV_DONTNEED and MADV_WILLNEED, checking its contents
+   each time.  Then checks that MADV_DONTNEED makes a private file
+   page read as the file again and an anonymous page read as
+   zeros, and that advice about unmapped memory fails. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+#define ANON ((char *) 0x20000000)
+#define PAGE 4096
+#define PAGE_CNT 32
+#define SIZE (PAGE_CNT * PAGE)
+
+static char buf[PAGE];
+
+/* Checks that page P of the mapping holds byte P throughout. */
+static void
+check_pages (void)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    if (ACTUAL[i] != (char) (i / PAGE))
+      fail ("byte %zu of mapping is %d", i, ACTUAL[i]);
+}
+
+void
+test_main (void)
+{
+  int handle;
+  int p;
+
+  CHECK (create ("advise.dat", SIZE), "create \"advise.dat\"");
+  CHECK ((handle = open ("advise.dat")) > 1, "open \"advise.dat\"");
+  for (p = 0; p < PAGE_CNT; p++)
+    {
+      memset (buf, p, PAGE);
+      if (write (handle, buf, PAGE) != PAGE)
+        fail ("write page %d of \"advise.dat\" failed", p);
+    }
+  CHECK (mmap_range (ACTUAL, SIZE, MAP_PRIVATE, handle, 0) != MAP_FAILED,
+         "mmap \"advise.dat\"");
+
+  CHECK (madvise (ACTUAL, SIZE, MADV_SEQUENTIAL), "madvise sequential");
+  check_pages ();
+  CHECK (madvise (ACTUAL, SIZE, MADV_DONTNEED), "madvise dontneed");
+  CHECK (madvise (ACTUAL, SIZE, MADV_WILLNEED), "madvise willneed");
+  check_pages ();
+
+  ACTUAL[0] = 'x';
+  CHECK (madvise (ACTUAL, PAGE, MADV_DONTNEED), "madvise dontneed page 0");
+  CHECK (ACTUAL[0] == 0, "private page reads from the file again");
+
+  CHECK (mmap_range (ANON, PAGE, MAP_ANON, -1, 0) != MAP_FAILED,
+         "mmap anonymous page");
+  ANON[0] = 'x';
+  CHECK (madvise (ANON, PAGE, MADV_DONTNEED), "madvise dontneed");
+  CHECK (ANON[0] == 0, "anonymous page reads as zeros again");
+
+  CHECK (!madvise (ACTUAL + SIZE, PAGE, MADV_WILLNEED),
+         "madvise of unmapped memory fails");
+}
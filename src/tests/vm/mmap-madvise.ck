@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-madvise) begin
+(mmap-madvise) create "advise.dat"
+(mmap-madvise) open "advise.dat"
+(mmap-madvise) mmap "advise.dat"
+(mmap-madvise) madvise sequential
+(mmap-madvise) madvise dontneed
+(mmap-madvise) madvise willneed
+(mmap-madvise) madvise dontneed page 0
+(mmap-madvise) private page reads from the file again
+(mmap-madvise) mmap anonymous page
+(mmap-madvise) madvise dontneed
+(mmap-madvise) anonymous page reads as zeros again
+(mmap-madvise) madvise of unmapped memory fails
+(mmap-madvise) end
+EOF
+pass;
@@ -0,0 +1,43 @@
+/* Checks that msync() writes a shared mapping's changes to its
+   file while it is still mapped, that it leaves the file alone
+   for a private mapping, and that it fails for a bad mapping. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SHARED ((char *) 0x10000000)
+#define PRIVATE ((char *) 0x20000000)
+
+void
+test_main (void)
+{
+  static const char data[] = "sync me";
+  char buf[sizeof data];
+  int handle;
+  mapid_t shared, private;
+
+  CHECK (create ("sync.dat", 8192), "create \"sync.dat\"");
+  CHECK ((handle = open ("sync.dat")) > 1, "open \"sync.dat\"");
+
+  CHECK ((shared = mmap_range (SHARED, 8192, MAP_SHARED, handle, 0))
+         != MAP_FAILED, "mmap \"sync.dat\" shared");
+  memcpy (SHARED + 4096, data, sizeof data);
+  CHECK (msync (shared), "msync shared mapping");
+  CHECK (pread (handle, buf, sizeof buf, 4096) == sizeof buf,
+         "read \"sync.dat\"");
+  CHECK (!memcmp (buf, data, sizeof data), "write reached the file");
+
+  CHECK ((private = mmap_range (PRIVATE, 8192, MAP_PRIVATE, handle, 0))
+         != MAP_FAILED, "mmap \"sync.dat\" private");
+  memcpy (PRIVATE, data, sizeof data);
+  CHECK (msync (private), "msync private mapping");
+  CHECK (pread (handle, buf, sizeof buf, 0) == sizeof buf,
+         "read \"sync.dat\"");
+  CHECK (buf[0] == 0, "file is unchanged");
+
+  CHECK (!msync (1234), "msync of bad mapping fails");
+  munmap (private);
+  munmap (shared);
+}
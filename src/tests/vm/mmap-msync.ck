@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-msync) begin
+(mmap-msync) create "sync.dat"
+(mmap-msync) open "sync.dat"
+(mmap-msync) mmap "sync.dat" shared
+(mmap-msync) msync shared mapping
+(mmap-msync) read "sync.dat"
+(mmap-msync) write reached the file
+(mmap-msync) mmap "sync.dat" private
+(mmap-msync) msync private mapping
+(mmap-msync) read "sync.dat"
+(mmap-msync) file is unchanged
+(mmap-msync) msync of bad mapping fails
+(mmap-msync) end
+EOF
+pass;
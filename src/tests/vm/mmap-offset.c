@@ -0,0 +1,51 @@
+/* Maps part of a file, from an offset, privately.  Checks that
+   the mapping holds the right bytes and that writes to it stay
+   out of the file, and that mappings at a misaligned offset or
+   reaching past the end of the file fail. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+#define PAGE 4096
+
+static char buf[PAGE];
+
+void
+test_main (void)
+{
+  int handle;
+  mapid_t map;
+  size_t i;
+  int p;
+
+  CHECK (create ("offset.dat", 3 * PAGE), "create \"offset.dat\"");
+  CHECK ((handle = open ("offset.dat")) > 1, "open \"offset.dat\"");
+  for (p = 0; p < 3; p++)
+    {
+      memset (buf, p + 1, PAGE);
+      if (write (handle, buf, PAGE) != PAGE)
+        fail ("write page %d of \"offset.dat\" failed", p);
+    }
+
+  CHECK ((map = mmap_range (ACTUAL, PAGE + 10, MAP_PRIVATE, handle, PAGE))
+         != MAP_FAILED, "mmap \"offset.dat\" from page 1");
+  for (i = 0; i < 2 * PAGE; i++)
+    if (ACTUAL[i] != (char) (i / PAGE + 2))
+      fail ("byte %zu of mapping is %d", i, ACTUAL[i]);
+
+  msg ("write to private mapping");
+  memset (ACTUAL, 'x', PAGE);
+  munmap (map);
+  CHECK (pread (handle, buf, PAGE, PAGE) == PAGE, "read page 1 of file");
+  for (i = 0; i < PAGE; i++)
+    if (buf[i] != 2)
+      fail ("private write reached the file");
+
+  CHECK (mmap_range (ACTUAL, PAGE, MAP_PRIVATE, handle, 100) == MAP_FAILED,
+         "mmap at misaligned offset fails");
+  CHECK (mmap_range (ACTUAL, 3 * PAGE, MAP_PRIVATE, handle, PAGE)
+         == MAP_FAILED, "mmap past end of file fails");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-offset) begin
+(mmap-offset) create "offset.dat"
+(mmap-offset) open "offset.dat"
+(mmap-offset) mmap "offset.dat" from page 1
+(mmap-offset) write to private mapping
+(mmap-offset) read page 1 of file
+(mmap-offset) mmap at misaligned offset fails
+(mmap-offset) mmap past end of file fails
+(mmap-offset) end
+EOF
+pass;
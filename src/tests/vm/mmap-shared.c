@@ -0,0 +1,41 @@
+/* Maps a file shared, then runs child-shared, which maps the
+   same file shared and writes to it.  Checks that the write shows
+   through this process's mapping, which was already in memory,
+   and that writes through the mapping reach the file on
+   munmap. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+  static const char message[] = "written by child-shared";
+  static const char reply[] = "written by mmap-shared";
+  char buf[sizeof reply];
+  int handle;
+  mapid_t map;
+  pid_t child;
+
+  CHECK (create ("shared.dat", 4096), "create \"shared.dat\"");
+  CHECK ((handle = open ("shared.dat")) > 1, "open \"shared.dat\"");
+  CHECK ((map = mmap_range (ACTUAL, 4096, MAP_SHARED, handle, 0))
+         != MAP_FAILED, "mmap \"shared.dat\" shared");
+  if (ACTUAL[0] != 0)
+    fail ("new file does not read as zeros");
+
+  CHECK ((child = exec ("child-shared")) != -1, "exec \"child-shared\"");
+  CHECK (wait (child) == 0, "wait for child (should return 0)");
+  CHECK (!memcmp (ACTUAL, message, sizeof message),
+         "child's write shows through mapping");
+
+  memcpy (ACTUAL, reply, sizeof reply);
+  munmap (map);
+  CHECK (pread (handle, buf, sizeof buf, 0) == sizeof buf,
+         "read \"shared.dat\"");
+  CHECK (!memcmp (buf, reply, sizeof reply), "write reached the file");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-shared) begin
+(mmap-shared) create "shared.dat"
+(mmap-shared) open "shared.dat"
+(mmap-shared) mmap "shared.dat" shared
+(mmap-shared) exec "child-shared"
+(child-shared) begin
+(child-shared) open "shared.dat"
+(child-shared) mmap "shared.dat" shared
+(child-shared) end
+(mmap-shared) wait for child (should return 0)
+(mmap-shared) child's write shows through mapping
+(mmap-shared) read "shared.dat"
+(mmap-shared) write reached the file
+(mmap-shared) end
+EOF
+pass;
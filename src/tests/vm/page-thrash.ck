@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = mask_figures (qr/^\(page-thrash\) (\d+) cycles per page touch$/,
+			@output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(page-thrash) begin
+(page-thrash) initialize
+(page-thrash) sweep 4 times
+(page-thrash) # cycles per page touch
+(page-thrash) verify
+(page-thrash) end
+EOF
+pass;
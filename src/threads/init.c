@@ -20,8 +20,11 @@
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
+#include "threads/trace.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/vmalloc.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
@@ -37,6 +40,7 @@
 #include "vm/frame.h"
 #include "threads/synch.h"
 #include "vm/page.h"
+#include "vm/share.h"
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
@@ -105,6 +109,8 @@ main (void)
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
+  profile_init ();
+  trace_init ();
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -120,6 +126,7 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  process_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
@@ -137,10 +144,10 @@ main (void)
 #ifdef VM
   /* Initialise the swap disk */  
   swap_init ();
-  // Initialising frame table
-  lock_init(&frame_table_lock);
-  hash_init(&frame_hash_table, frame_hash, frame_less, NULL);
-  lock_init(&spt_lock);
+  // Initialising frame table and supplemental page tables
+  frame_init();
+  spt_init();
+  share_init();
 #endif
 
   printf ("Boot complete.\n");
@@ -196,6 +203,9 @@ paging_init (void)
       pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text);
     }
 
+  /* Reserve kernel virtual memory for vmalloc. */
+  vmalloc_init (pd);
+
   /* Store the physical address of the page directory into CR3
      aka PDBR (page directory base register).  This activates our
      new page tables immediately.  See [IA32-v2a] "MOV--Move
@@ -272,6 +282,15 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-fair"))
+        thread_fair = true;
+      else if (!strcmp (name, "-profile"))
+        profile_configure (value != NULL ? atoi (value) : 0);
+      else if (!strcmp (name, "-trace"))
+        {
+          if (!trace_configure (value))
+            PANIC ("unknown trace category in `%s'", value);
+        }
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
@@ -280,6 +299,9 @@ parse_options (char **argv)
         PANIC ("unknown option `%s' (use -h for help)", name);
     }
 
+  if (thread_mlfqs && thread_fair)
+    PANIC ("options -mlfqs and -fair are mutually exclusive");
+
   /* Initialize the random number generator based on the system
      time.  This has no effect if an "-rs" option was specified.
 
@@ -395,6 +417,10 @@ usage (void)
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -fair              Use fair-share (virtual runtime) scheduler.\n"
+          "  -profile[=DEPTH]   Sample eip, and DEPTH callers, every tick.\n"
+          "  -trace[=CAT,...]   Trace events in categories sched, syscall,\n"
+          "                     vm, swap, disk (default all).\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
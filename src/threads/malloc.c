@@ -8,6 +8,7 @@
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "threads/vmalloc.h"
 
 /* A simple implementation of malloc().
 
@@ -30,9 +31,12 @@
 
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   descriptor.  We handle those by allocating pages and sticking
+   the allocation size at the beginning of the allocated block's
+   arena header.  A block that needs more than one page comes
+   from vmalloc, which maps scattered physical pages at
+   contiguous virtual addresses, so it does not fail just because
+   the kernel pool is fragmented. */
 
 /* Descriptor. */
 struct desc
@@ -107,7 +111,10 @@ malloc (size_t size)
       /* SIZE is too big for any descriptor.
          Allocate enough pages to hold SIZE plus an arena. */
       size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
-      a = palloc_get_multiple (0, page_cnt);
+      if (page_cnt == 1)
+        a = palloc_get_page (0);
+      else
+        a = vmalloc_get_multiple (page_cnt);
       if (a == NULL)
         return NULL;
 
@@ -257,7 +264,10 @@ free (void *p)
       else
         {
           /* It's a big block.  Free its pages. */
-          palloc_free_multiple (a, a->free_cnt);
+          if (is_vmalloc_vaddr (a))
+            vmalloc_free_multiple (a, a->free_cnt);
+          else
+            palloc_free_page (a);
           return;
         }
     }
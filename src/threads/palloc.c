@@ -1,14 +1,14 @@
 #include "threads/palloc.h"
-#include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
-#include "threads/synch.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -23,22 +23,74 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is managed as a binary buddy system.  Free memory is
+   kept as blocks of 2**K pages, for "orders" K from 0 to
+   MAX_ORDER, each aligned to its own size relative to the pool
+   base, with one free list per order.  An allocation takes a
+   block from the smallest nonempty list that is big enough,
+   splitting it in half repeatedly and returning the unused
+   halves to the lower-order lists.  A freed block is merged with
+   its "buddy", the other half of the block it was split from,
+   for as long as the buddy is also free.  Both operations take
+   O(MAX_ORDER) time regardless of how fragmented the pool is.
+
+   Requests that are not a power of two are served from the next
+   larger block, with the pages past the end of the request freed
+   again immediately, so palloc_free_multiple() can free any run
+   of pages that palloc_get_multiple() returned.
+
+   The pools are protected by disabling interrupts rather than by
+   a lock, because a dying thread's page is freed from
+   thread_schedule_tail(), where sleeping is impossible.  The
+   critical sections are short and bounded by MAX_ORDER.
+
+   While the system is idle, the idle thread takes single free
+   pages, zeroes them, and parks them on a per-pool list, from
+   which PAL_ZERO requests for one page are then served without a
+   memset.  Parked pages are handed back to the buddy system
+   whenever an allocation would otherwise fail. */
+
+/* Largest block order.  A pool's largest block is 2**MAX_ORDER
+   pages (4 GB), more than any pool can hold. */
+#define MAX_ORDER 20
 
 /* A memory pool. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
+    struct list free_lists[MAX_ORDER + 1]; /* Free blocks by order. */
+    uint8_t *free_order;                /* Per page: order + 1 if the
+                                           page begins a free block,
+                                           otherwise 0. */
+    size_t page_cnt;                    /* Number of pages. */
+    size_t free_cnt;                    /* Number of free pages. */
+    struct list zeroed_pages;           /* Pre-zeroed pages. */
+    size_t zeroed_cnt;                  /* Number of pre-zeroed pages. */
     uint8_t *base;                      /* Base of pool. */
   };
 
+/* Maximum number of pre-zeroed pages kept in each pool. */
+#define ZEROED_MAX 64
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* Statistics. */
+static long long zero_requests;  /* # of PAL_ZERO requests. */
+static long long prezeroed_hits; /* # served from a pre-zeroed list. */
+
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static unsigned order_for (size_t page_cnt);
+static void free_block (struct pool *, size_t page_idx, unsigned order);
+static void free_range (struct pool *, size_t page_idx, size_t page_cnt);
+static struct list_elem *block_elem (const struct pool *, size_t page_idx);
+static void *take_block (struct pool *, size_t page_cnt);
+static void *take_zeroed_page (struct pool *);
+static void release_zeroed_pages (struct pool *);
+static bool prezero_page (struct pool *);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -72,23 +124,41 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
   void *pages;
-  size_t page_idx;
+  bool zeroed = false;
+  enum intr_level old_level;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
-
-  if (page_idx != BITMAP_ERROR)
-    pages = pool->base + PGSIZE * page_idx;
+  old_level = intr_disable ();
+  if ((flags & PAL_ZERO) && page_cnt == 1
+      && !list_empty (&pool->zeroed_pages))
+    {
+      pages = take_zeroed_page (pool);
+      zeroed = true;
+    }
   else
-    pages = NULL;
+    {
+      pages = take_block (pool, page_cnt);
+      if (pages == NULL && !list_empty (&pool->zeroed_pages))
+        {
+          /* Pages parked on the pre-zeroed list may be all that
+             stands between us and success. */
+          release_zeroed_pages (pool);
+          pages = take_block (pool, page_cnt);
+        }
+    }
+  if (flags & PAL_ZERO)
+    {
+      zero_requests++;
+      if (zeroed)
+        prezeroed_hits++;
+    }
+  intr_set_level (old_level);
 
   if (pages != NULL) 
     {
-      if (flags & PAL_ZERO)
+      if ((flags & PAL_ZERO) && !zeroed)
         memset (pages, 0, PGSIZE * page_cnt);
     }
   else 
@@ -119,6 +189,7 @@ palloc_free_multiple (void *pages, size_t page_cnt)
 {
   struct pool *pool;
   size_t page_idx;
+  enum intr_level old_level;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
@@ -132,13 +203,15 @@ palloc_free_multiple (void *pages, size_t page_cnt)
     NOT_REACHED ();
 
   page_idx = pg_no (pages) - pg_no (pool->base);
+  ASSERT (page_idx + page_cnt <= pool->page_cnt);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  old_level = intr_disable ();
+  free_range (pool, page_idx, page_cnt);
+  intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -148,25 +221,54 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Zeroes one free page and sets it aside for a later PAL_ZERO
+   request, if either pool wants more pre-zeroed pages.  Returns
+   true if a page was zeroed, false if there was nothing to do.
+
+   Called by the idle thread, with interrupts on, so that a
+   thread that becomes ready need not wait for the memset. */
+bool
+palloc_prezero_page (void) 
+{
+  return prezero_page (&kernel_pool) || prezero_page (&user_pool);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) 
+{
+  printf ("Palloc: %lld of %lld zeroed page requests served pre-zeroed\n",
+          prezeroed_hits, zero_requests);
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+  /* We'll put the pool's free_order array at its base.
+     Calculate the space needed for the array
      and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  size_t meta_pages = DIV_ROUND_UP (page_cnt, PGSIZE);
+  unsigned k;
+
+  if (meta_pages > page_cnt)
+    PANIC ("Not enough memory in %s for free page map.", name);
+  page_cnt -= meta_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  for (k = 0; k <= MAX_ORDER; k++)
+    list_init (&p->free_lists[k]);
+  p->free_order = base;
+  memset (p->free_order, 0, page_cnt);
+  p->page_cnt = page_cnt;
+  p->free_cnt = 0;
+  list_init (&p->zeroed_pages);
+  p->zeroed_cnt = 0;
+  p->base = base + meta_pages * PGSIZE;
+  free_range (p, 0, page_cnt);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -176,7 +278,168 @@ page_from_pool (const struct pool *pool, void *page)
 {
   size_t page_no = pg_no (page);
   size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the order of the smallest block that holds PAGE_CNT
+   pages, or MAX_ORDER + 1 if no block is that large. */
+static unsigned
+order_for (size_t page_cnt) 
+{
+  unsigned order = 0;
+
+  while (order <= MAX_ORDER && ((size_t) 1 << order) < page_cnt)
+    order++;
+  return order;
+}
+
+/* Returns the list element stored at the start of the free
+   block that begins at PAGE_IDX in POOL. */
+static struct list_elem *
+block_elem (const struct pool *pool, size_t page_idx) 
+{
+  return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Adds the block of 2**ORDER pages at PAGE_IDX in POOL to the
+   free lists, first merging it with its buddy for as long as the
+   buddy is free too.  Interrupts must be off. */
+static void
+free_block (struct pool *pool, size_t page_idx, unsigned order) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (pool->free_order[page_idx] == 0);
+
+  pool->free_cnt += (size_t) 1 << order;
+  for (; order < MAX_ORDER; order++)
+    {
+      size_t buddy_idx = page_idx ^ ((size_t) 1 << order);
+
+      if (buddy_idx + ((size_t) 1 << order) > pool->page_cnt
+          || pool->free_order[buddy_idx] != order + 1)
+        break;
+
+      list_remove (block_elem (pool, buddy_idx));
+      pool->free_order[buddy_idx] = 0;
+      page_idx &= ~((size_t) 1 << order);
+    }
+
+  pool->free_order[page_idx] = order + 1;
+  list_push_front (&pool->free_lists[order], block_elem (pool, page_idx));
+}
+
+/* Frees the PAGE_CNT pages starting at PAGE_IDX in POOL, which
+   need not form a single block, by splitting them into the
+   largest aligned blocks possible.  Interrupts must be off. */
+static void
+free_range (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  while (page_cnt > 0)
+    {
+      unsigned order = 0;
+
+      while (order < MAX_ORDER
+             && (page_idx & (((size_t) 2 << order) - 1)) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+
+      free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Removes a run of PAGE_CNT pages from POOL's free lists and
+   returns its address, or returns a null pointer if POOL has no
+   free block that large.  Interrupts must be off. */
+static void *
+take_block (struct pool *pool, size_t page_cnt) 
+{
+  unsigned order = order_for (page_cnt);
+  unsigned k;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (k = order; k <= MAX_ORDER; k++)
+    if (!list_empty (&pool->free_lists[k]))
+      {
+        struct list_elem *e = list_pop_front (&pool->free_lists[k]);
+        size_t page_idx = ((uint8_t *) e - pool->base) / PGSIZE;
+        pool->free_order[page_idx] = 0;
+        pool->free_cnt -= (size_t) 1 << k;
+
+        /* Split the block down to the order requested. */
+        while (k > order)
+          {
+            k--;
+            free_block (pool, page_idx + ((size_t) 1 << k), k);
+          }
+
+        /* Give back the pages past the end of the request. */
+        free_range (pool, page_idx + page_cnt,
+                    ((size_t) 1 << order) - page_cnt);
+
+        return pool->base + PGSIZE * page_idx;
+      }
+  return NULL;
+}
+
+/* Removes a page from POOL's pre-zeroed list, which must not be
+   empty, and returns it.  Interrupts must be off. */
+static void *
+take_zeroed_page (struct pool *pool) 
+{
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  e = list_pop_front (&pool->zeroed_pages);
+  pool->zeroed_cnt--;
+
+  /* The list element was the only thing written to the page. */
+  memset (e, 0, sizeof *e);
+  return e;
+}
+
+/* Returns all of POOL's pre-zeroed pages to its free lists.
+   Interrupts must be off. */
+static void
+release_zeroed_pages (struct pool *pool) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (!list_empty (&pool->zeroed_pages))
+    {
+      struct list_elem *e = list_pop_front (&pool->zeroed_pages);
+      free_block (pool, ((uint8_t *) e - pool->base) / PGSIZE, 0);
+    }
+  pool->zeroed_cnt = 0;
+}
+
+/* Zeroes a free page from POOL onto its pre-zeroed list, unless
+   the list is full or already holds as many pages as remain
+   free.  Returns true if a page was zeroed, false otherwise. */
+static bool
+prezero_page (struct pool *pool) 
+{
+  enum intr_level old_level;
+  void *page = NULL;
+
+  old_level = intr_disable ();
+  if (pool->zeroed_cnt < ZEROED_MAX && pool->zeroed_cnt < pool->free_cnt)
+    page = take_block (pool, 1);
+  intr_set_level (old_level);
+
+  if (page == NULL)
+    return false;
+
+  memset (page, 0, PGSIZE);
+
+  old_level = intr_disable ();
+  list_push_front (&pool->zeroed_pages, page);
+  pool->zeroed_cnt++;
+  intr_set_level (old_level);
+  return true;
+}
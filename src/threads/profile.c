@@ -0,0 +1,145 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Statistical kernel profiler.
+
+   When enabled by the "-profile" option, every timer interrupt
+   records the eip that it interrupted, and optionally the return
+   addresses of up to PROFILE_MAX_DEPTH callers found by following
+   saved frame pointers, into a ring buffer.  Once the buffer is
+   full, new samples overwrite the oldest.
+
+   At shutdown the samples are printed one per line, as
+   "Profile sample:" followed by the addresses, innermost first.
+   utils/profile turns that output into flat and call-graph
+   profiles against kernel.o.  A sample taken while a user
+   program was running is recorded as the single address 0. */
+
+/* Number of pages in the ring buffer. */
+#define PROFILE_PAGES 64
+
+/* One sample. */
+struct sample
+  {
+    uintptr_t pcs[PROFILE_MAX_DEPTH + 1]; /* Innermost first, 0-padded. */
+  };
+
+static int sample_depth = -1;   /* Callers per sample, -1 if disabled. */
+static struct sample *samples;  /* Ring buffer, or null if not sampling. */
+static size_t sample_cap;       /* Number of samples in the ring. */
+static size_t sample_next;      /* Ring index of the next sample. */
+static int64_t sample_cnt;      /* Number of samples ever taken. */
+
+/* Enables the profiler, recording up to DEPTH callers with each
+   sample.  Called while parsing the command line, before memory
+   is available; profile_init() then starts sampling. */
+void
+profile_configure (int depth)
+{
+  if (depth < 0)
+    depth = 0;
+  sample_depth = depth < PROFILE_MAX_DEPTH ? depth : PROFILE_MAX_DEPTH;
+}
+
+/* Allocates the ring buffer and starts sampling, if the profiler
+   was enabled. */
+void
+profile_init (void)
+{
+  struct sample *buf;
+
+  if (sample_depth < 0)
+    return;
+
+  buf = palloc_get_multiple (0, PROFILE_PAGES);
+  if (buf == NULL)
+    {
+      printf ("profile: could not allocate sample buffer\n");
+      return;
+    }
+  sample_cap = PROFILE_PAGES * PGSIZE / sizeof *samples;
+  samples = buf;
+}
+
+/* Records a sample of the code interrupted by the timer
+   interrupt whose frame is F. */
+void
+profile_sample (const struct intr_frame *f)
+{
+  struct sample *s;
+  int i;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (samples == NULL)
+    return;
+
+  s = &samples[sample_next];
+  sample_next = (sample_next + 1) % sample_cap;
+  sample_cnt++;
+  for (i = 0; i <= PROFILE_MAX_DEPTH; i++)
+    s->pcs[i] = 0;
+
+  if ((f->cs & 3) == 3)
+    return;
+  s->pcs[0] = (uintptr_t) f->eip;
+
+  /* Follow saved frame pointers as long as they stay within the
+     current thread's kernel stack and keep moving up it. */
+  if (sample_depth > 0)
+    {
+      uint8_t *stack = (uint8_t *) thread_current ();
+      void **frame = (void **) f->ebp;
+
+      for (i = 1; i <= sample_depth; i++)
+        {
+          if ((uint8_t *) frame <= stack
+              || (uint8_t *) (frame + 2) > stack + PGSIZE)
+            break;
+          s->pcs[i] = (uintptr_t) frame[1];
+          if ((void **) frame[0] <= frame)
+            break;
+          frame = frame[0];
+        }
+    }
+}
+
+/* Stops sampling and prints the samples in the ring buffer,
+   oldest first. */
+void
+profile_dump (void)
+{
+  enum intr_level old_level;
+  struct sample *buf;
+  size_t cnt, i;
+
+  /* Detach the buffer so that no sample is taken mid-dump. */
+  old_level = intr_disable ();
+  buf = samples;
+  samples = NULL;
+  intr_set_level (old_level);
+  if (buf == NULL)
+    return;
+
+  cnt = sample_cnt < (int64_t) sample_cap ? sample_cnt : sample_cap;
+  printf ("Profile: %"PRId64" samples, %"PRId64" overwritten, depth %d.\n",
+          sample_cnt, sample_cnt - (int64_t) cnt, sample_depth);
+  for (i = 0; i < cnt; i++)
+    {
+      const struct sample *s
+        = &buf[(sample_next + sample_cap - cnt + i) % sample_cap];
+      int j;
+
+      printf ("Profile sample: %#"PRIxPTR, s->pcs[0]);
+      for (j = 1; j <= sample_depth && s->pcs[j] != 0; j++)
+        printf (" %#"PRIxPTR, s->pcs[j]);
+      printf ("\n");
+    }
+}
@@ -0,0 +1,264 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator for objects of a single type.
+
+   malloc() rounds every request up to a power of two, so a
+   532-byte object occupies a 1 kB block and a 20-byte object a
+   32-byte one.  A kmem_cache instead packs objects of exactly one
+   size, rounded up only to OBJ_ALIGN, into page-size "slabs"
+   obtained from the page allocator.  Each slab starts with a
+   header and keeps its free objects on a singly linked list
+   threaded through the objects themselves.
+
+   A cache tracks its slabs on two lists: "partial" slabs, which
+   have at least one free object, and "full" slabs, which have
+   none.  Allocation takes an object from the first partial slab,
+   so it never scans.  When the last object in a slab is freed,
+   the slab is kept as the cache's single spare, or returned to
+   the page allocator if there already is one, so that a workload
+   that repeatedly allocates and frees one object does not keep
+   allocating and freeing pages.
+
+   If the cache has a constructor, each object is constructed
+   once, when its slab is created, and is assumed to be returned
+   to the cache in its constructed state.  The free-list link then
+   lives just past the end of the object instead of inside it. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Alignment of objects within a slab. */
+#define OBJ_ALIGN 8
+
+/* Slab header, at the start of each slab's page. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in cache's partial or full list. */
+    void *free;                 /* First free object, or null. */
+    size_t in_use;              /* Number of objects allocated. */
+  };
+
+/* Offset of the first object in a slab. */
+#define SLAB_OBJ_OFS ROUND_UP (sizeof (struct slab), OBJ_ALIGN)
+
+/* All caches, for statistics. */
+static struct list all_caches = LIST_INITIALIZER (all_caches);
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+static void **obj_link (struct kmem_cache *, void *);
+
+/* Initializes CACHE to allocate objects of SIZE bytes, naming it
+   NAME for statistics.  If CTOR is nonnull, it is called on each
+   object when the object's slab is created.  SIZE must leave room
+   for at least one object in a page-size slab. */
+void
+kmem_cache_init (struct kmem_cache *cache, const char *name, size_t size,
+                 kmem_ctor_func *ctor)
+{
+  ASSERT (cache != NULL);
+  ASSERT (size > 0);
+
+  cache->name = name;
+  cache->obj_size = size;
+  cache->ctor = ctor;
+  if (ctor != NULL)
+    {
+      cache->link_ofs = ROUND_UP (size, sizeof (void *));
+      cache->stride = ROUND_UP (cache->link_ofs + sizeof (void *),
+                                OBJ_ALIGN);
+    }
+  else
+    {
+      cache->link_ofs = 0;
+      cache->stride = ROUND_UP (size < sizeof (void *)
+                                ? sizeof (void *) : size, OBJ_ALIGN);
+    }
+  ASSERT (cache->stride <= PGSIZE - SLAB_OBJ_OFS);
+  cache->objs_per_slab = (PGSIZE - SLAB_OBJ_OFS) / cache->stride;
+
+  lock_init (&cache->lock);
+  list_init (&cache->partial);
+  list_init (&cache->full);
+  cache->empty = NULL;
+  cache->slab_cnt = 0;
+  cache->in_use = 0;
+  list_push_back (&all_caches, &cache->elem);
+}
+
+/* Allocates and returns an object from CACHE, or returns a null
+   pointer if memory is not available.  The object is not zeroed,
+   but if CACHE has a constructor, it is in its constructed
+   state. */
+void *
+kmem_cache_alloc (struct kmem_cache *cache)
+{
+  struct slab *s;
+  void *obj;
+
+  lock_acquire (&cache->lock);
+
+  if (list_empty (&cache->partial))
+    {
+      if (cache->empty != NULL)
+        {
+          s = cache->empty;
+          cache->empty = NULL;
+        }
+      else
+        {
+          s = slab_create (cache);
+          if (s == NULL)
+            {
+              lock_release (&cache->lock);
+              return NULL;
+            }
+        }
+      list_push_front (&cache->partial, &s->elem);
+    }
+
+  s = list_entry (list_front (&cache->partial), struct slab, elem);
+  obj = s->free;
+  s->free = *obj_link (cache, obj);
+  s->in_use++;
+  cache->in_use++;
+  if (s->free == NULL)
+    {
+      list_remove (&s->elem);
+      list_push_front (&cache->full, &s->elem);
+    }
+
+  lock_release (&cache->lock);
+  return obj;
+}
+
+/* Returns OBJ, which must have been allocated from CACHE, to
+   CACHE.  A null OBJ is ignored. */
+void
+kmem_cache_free (struct kmem_cache *cache, void *obj)
+{
+  struct slab *s;
+
+  if (obj == NULL)
+    return;
+
+  s = obj_to_slab (cache, obj);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs, unless
+     it must keep its constructed state. */
+  if (cache->ctor == NULL)
+    memset (obj, 0xcc, cache->obj_size);
+#endif
+
+  lock_acquire (&cache->lock);
+
+  ASSERT (s->in_use > 0);
+  if (s->free == NULL)
+    {
+      /* The slab was full and is now partial. */
+      list_remove (&s->elem);
+      list_push_front (&cache->partial, &s->elem);
+    }
+  *obj_link (cache, obj) = s->free;
+  s->free = obj;
+  s->in_use--;
+  cache->in_use--;
+
+  if (s->in_use == 0)
+    {
+      list_remove (&s->elem);
+      if (cache->empty == NULL)
+        cache->empty = s;
+      else
+        {
+          cache->slab_cnt--;
+          s->magic = 0;
+          palloc_free_page (s);
+        }
+    }
+
+  lock_release (&cache->lock);
+}
+
+/* Prints slab allocator statistics. */
+void
+kmem_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    {
+      struct kmem_cache *cache = list_entry (e, struct kmem_cache, elem);
+      printf ("Slab %s: %zu objects of %zu bytes in use, %zu slabs\n",
+              cache->name, cache->in_use, cache->obj_size, cache->slab_cnt);
+    }
+}
+
+/* Allocates a new slab for CACHE, threads its objects onto the
+   slab's free list, and returns it.  Returns a null pointer if
+   memory is not available.  CACHE's lock must be held. */
+static struct slab *
+slab_create (struct kmem_cache *cache)
+{
+  struct slab *s;
+  uint8_t *obj;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&cache->lock));
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = cache;
+  s->free = NULL;
+  s->in_use = 0;
+
+  /* Thread the objects in reverse so that they are handed out in
+     address order. */
+  obj = (uint8_t *) s + SLAB_OBJ_OFS + cache->objs_per_slab * cache->stride;
+  for (i = 0; i < cache->objs_per_slab; i++)
+    {
+      obj -= cache->stride;
+      if (cache->ctor != NULL)
+        cache->ctor (obj);
+      *obj_link (cache, obj) = s->free;
+      s->free = obj;
+    }
+
+  cache->slab_cnt++;
+  return s;
+}
+
+/* Returns the slab that contains OBJ, which must belong to
+   CACHE. */
+static struct slab *
+obj_to_slab (struct kmem_cache *cache, void *obj)
+{
+  struct slab *s = pg_round_down (obj);
+
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == cache);
+  ASSERT ((pg_ofs (obj) - SLAB_OBJ_OFS) % cache->stride == 0);
+
+  return s;
+}
+
+/* Returns the location of OBJ's free-list link. */
+static void **
+obj_link (struct kmem_cache *cache, void *obj)
+{
+  return (void **) ((uint8_t *) obj + cache->link_ofs);
+}
@@ -190,6 +190,7 @@ lock_init (struct lock *lock)
   ASSERT (lock != NULL);
 
   lock->holder = NULL;
+  lock->max_priority = PRI_MIN - 1;
   sema_init (&lock->semaphore, 1);
 }
 
@@ -209,13 +210,13 @@ lock_acquire (struct lock *lock)
   ASSERT (!lock_held_by_current_thread (lock));
 
   struct thread *thread = thread_current();
-  if ((lock->holder != NULL) && (lock->holder->priority < thread_get_priority())) {
-    thread->lock_waiting_for = lock;
+  thread->lock_waiting_for = lock;
+  if (lock->holder != NULL) {
     donate_priority(lock);
   }
   sema_down (&lock->semaphore);
-  lock->holder = thread;
   thread->lock_waiting_for = NULL;
+  hold_lock(lock);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -234,7 +235,7 @@ lock_try_acquire (struct lock *lock)
 
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    hold_lock (lock);
   return success;
 }
 
@@ -366,3 +367,253 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes RW as an unheld reader-writer lock.
+
+   A writer holds RW's internal lock for the whole of its write,
+   and each reader passes through the same lock on its way in.
+   Threads blocked behind a writer, whether readers or writers,
+   therefore donate their priority to it in the usual way.  Once a
+   writer has the internal lock no new reader can enter, which
+   gives writers preference: the writer only has to wait for the
+   readers already inside to leave.
+
+   While it waits, the writer donates its priority to each of
+   those readers through the lock in the reader's rwlock_hold.
+   Donations that reach the writer later pass on to only one of
+   them, since a thread waits on only one lock at a time.  A
+   thread that already holds RWLOCK_READ_MAX reader-writer locks
+   for reading gets no hold for another, and so no donations
+   through it. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->write_lock);
+  rw->readers = 0;
+  rw->writer_waiting = false;
+  sema_init (&rw->drained, 0);
+  list_init (&rw->holds);
+}
+
+/* Returns the current thread's hold on RW, or a free hold if RW
+   is null, or a null pointer if there is none. */
+static struct rwlock_hold *
+find_hold (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  size_t i;
+
+  for (i = 0; i < RWLOCK_READ_MAX; i++)
+    if (cur->read_holds[i].rw == rw)
+      return &cur->read_holds[i];
+  return NULL;
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   is waiting for it.  The current thread must not already hold
+   RW for writing.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw)
+{
+  enum intr_level old_level;
+  struct rwlock_hold *hold;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rw->write_lock);
+  hold = find_hold (NULL);
+  if (hold != NULL)
+    {
+      lock_init (&hold->lock);
+      lock_acquire (&hold->lock);
+      hold->rw = rw;
+    }
+  old_level = intr_disable ();
+  rw->readers++;
+  if (hold != NULL)
+    list_push_back (&rw->holds, &hold->elem);
+  intr_set_level (old_level);
+  lock_release (&rw->write_lock);
+}
+
+/* Releases RW, which the current thread must hold for reading.
+   If this is the last reader and a writer is waiting, lets the
+   writer in. */
+void
+rwlock_release_read (struct rwlock *rw)
+{
+  enum intr_level old_level;
+  struct rwlock_hold *hold;
+  bool wake_writer;
+
+  ASSERT (rw != NULL);
+
+  hold = find_hold (rw);
+  old_level = intr_disable ();
+  ASSERT (rw->readers > 0);
+  rw->readers--;
+  if (hold != NULL)
+    list_remove (&hold->elem);
+  wake_writer = rw->readers == 0 && rw->writer_waiting;
+  if (wake_writer)
+    rw->writer_waiting = false;
+  intr_set_level (old_level);
+
+  /* Give up any donation before letting the writer in. */
+  if (hold != NULL)
+    {
+      hold->rw = NULL;
+      lock_release (&hold->lock);
+    }
+  if (wake_writer)
+    sema_up (&rw->drained);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  New readers are held off as soon as this function is
+   entered.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rw->write_lock);
+  old_level = intr_disable ();
+  while (rw->readers > 0)
+  {
+    struct thread *cur = thread_current ();
+    struct list_elem *e;
+
+    /* Donate to each reader inside.  The last one stays the lock
+       this thread waits for, so donations to it pass on. */
+    for (e = list_begin (&rw->holds); e != list_end (&rw->holds);
+         e = list_next (e))
+      {
+        struct rwlock_hold *hold = list_entry (e, struct rwlock_hold, elem);
+        cur->lock_waiting_for = &hold->lock;
+        donate_priority (&hold->lock);
+      }
+    rw->writer_waiting = true;
+    sema_down (&rw->drained);
+    cur->lock_waiting_for = NULL;
+  }
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rwlock_release_write (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_release (&rw->write_lock);
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
+bool
+rwlock_write_held_by_current_thread (const struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  return lock_held_by_current_thread (&rw->write_lock);
+}
+
+/* Initializes SL as a sequence lock with no write in progress.
+
+   A typical reader looks like this:
+
+     unsigned seq;
+     do
+       {
+         seq = seqlock_read_begin (&sl);
+         copy = record;
+       }
+     while (seqlock_read_retry (&sl, seq));
+
+   Writers bracket their updates with seqlock_write_begin() and
+   seqlock_write_end().  Both readers and writers may run in an
+   interrupt handler, so a record such as load_avg that the timer
+   interrupt updates can be protected by a seqlock. */
+void
+seqlock_init (struct seqlock *sl)
+{
+  ASSERT (sl != NULL);
+
+  sl->seq = 0;
+}
+
+/* Begins a read of the record protected by SL and returns the
+   sequence number to pass to seqlock_read_retry().  Waits, by
+   re-reading the sequence number, while a write is in
+   progress. */
+unsigned
+seqlock_read_begin (struct seqlock *sl)
+{
+  unsigned seq;
+
+  ASSERT (sl != NULL);
+
+  while ((seq = sl->seq) & 1)
+    barrier ();
+  barrier ();
+  return seq;
+}
+
+/* Returns true if the record protected by SL may have changed
+   since the seqlock_read_begin() call that returned START, in
+   which case the read must be repeated. */
+bool
+seqlock_read_retry (const struct seqlock *sl, unsigned start)
+{
+  ASSERT (sl != NULL);
+
+  barrier ();
+  return sl->seq != start;
+}
+
+/* Begins an update of the record protected by SL.
+
+   The update runs with interrupts disabled until the matching
+   seqlock_write_end(), which on a uniprocessor is enough to keep
+   out other writers and to keep readers from seeing the record
+   part-way through.  The update must therefore be short and must
+   not sleep. */
+void
+seqlock_write_begin (struct seqlock *sl)
+{
+  enum intr_level old_level;
+
+  ASSERT (sl != NULL);
+
+  old_level = intr_disable ();
+  sl->seq++;
+  sl->old_level = old_level;
+  barrier ();
+}
+
+/* Ends an update of the record protected by SL and restores the
+   interrupt level from before seqlock_write_begin(). */
+void
+seqlock_write_end (struct seqlock *sl)
+{
+  ASSERT (sl != NULL);
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (sl->seq & 1);
+
+  barrier ();
+  sl->seq++;
+  intr_set_level (sl->old_level);
+}
@@ -2,7 +2,9 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <rbtree.h>
 #include <stdbool.h>
+#include "threads/interrupt.h"
 
 /* A counting semaphore. */
 struct semaphore 
@@ -22,6 +24,8 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    int max_priority;           /* Highest priority donated by a waiter. */
+    struct rb_elem held_elem;   /* Element in holder's held_locks. */
   };
 
 void lock_init (struct lock *);
@@ -41,6 +45,57 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock.  Any number of readers or a single writer
+   may hold it at a time.  Waiting writers take precedence over
+   new readers. */
+struct rwlock
+  {
+    struct lock write_lock;     /* Held by the writer, and briefly by
+                                   each reader on the way in. */
+    unsigned readers;           /* Number of readers holding the lock. */
+    bool writer_waiting;        /* Writer waiting for readers to leave. */
+    struct semaphore drained;   /* Upped when the last reader leaves. */
+    struct list holds;          /* Readers' rwlock_holds. */
+  };
+
+/* A thread's hold on a reader-writer lock for reading.  The
+   reader holds LOCK while it reads, so a writer waiting for it to
+   leave can donate its priority through LOCK. */
+struct rwlock_hold
+  {
+    struct rwlock *rw;          /* Lock held for reading, or null. */
+    struct lock lock;           /* Held by the reader while it reads. */
+    struct list_elem elem;      /* Element in RW's holds list. */
+  };
+
+/* Number of reader-writer locks that a thread can hold for
+   reading at once and still receive donations through. */
+#define RWLOCK_READ_MAX 4
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_write_held_by_current_thread (const struct rwlock *);
+
+/* Sequence lock, for small records that are read far more often
+   than they are written.  Readers never block writers: they take
+   a snapshot of the sequence number, copy the record, and retry
+   if a write happened in the meantime.  Writers run with
+   interrupts disabled. */
+struct seqlock
+  {
+    unsigned seq;               /* Odd while a write is in progress. */
+    enum intr_level old_level;  /* Interrupt level before the write. */
+  };
+
+void seqlock_init (struct seqlock *);
+unsigned seqlock_read_begin (struct seqlock *);
+bool seqlock_read_retry (const struct seqlock *, unsigned start);
+void seqlock_write_begin (struct seqlock *);
+void seqlock_write_end (struct seqlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
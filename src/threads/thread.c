@@ -11,6 +11,7 @@
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include "threads/fixed-point-arith.h"
 #include "vm/page.h"
@@ -30,10 +31,45 @@ static struct list ready_list;
 /* List of processes in THREAD_READY state for the advanced scheduler */
 static struct list ready_queues[PRI_MAX + 1];
 
+/* Tree of processes in THREAD_READY state for the fair-share
+   scheduler, ordered by vruntime so that the thread that has had
+   the least weighted CPU time is always leftmost. */
+static struct rb_tree fair_tree;
+
+/* Lower bound on the vruntime of every runnable thread under the
+   fair-share scheduler.  Never decreases.  Threads entering the
+   run tree are placed relative to it so that they can neither
+   starve the others nor be starved. */
+static int64_t fair_min_vruntime;
+
+/* Fair-share weight of each nice value from NICE_MIN to NICE_MAX.
+   Each step of nice changes a thread's share of the CPU by about
+   10% relative to a competing thread. */
+static const int fair_weights[NICE_MAX - NICE_MIN + 1] =
+  {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */  9548,  7620,  6100,  4904,  3906,
+    /*  -5 */  3121,  2501,  1991,  1586,  1277,
+    /*   0 */  1024,   820,   655,   526,   423,
+    /*   5 */   335,   272,   215,   172,   137,
+    /*  10 */   110,    87,    70,    56,    45,
+    /*  15 */    36,    29,    23,    18,    15,
+    /*  20 */    12,
+  };
+
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 static struct list all_list;
 
+/* Table of all threads keyed by tid, so that get_thread_by_tid()
+   does not have to walk all_list.  The buckets are static so that
+   the table can be used before malloc_init() and with interrupts
+   off.  Tids are handed out sequentially, so taking them modulo
+   the bucket count spreads live threads evenly. */
+#define TID_BUCKET_CNT 64
+static struct list tid_buckets[TID_BUCKET_CNT];
+
 /* Idle thread. */
 static struct thread *idle_thread;
 
@@ -56,6 +92,17 @@ static long long idle_ticks;    /* # of timer ticks spent idle. */
 static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
 static long long user_ticks;    /* # of timer ticks in user programs. */
 
+/* Cache of pages released by dying threads.  thread_create()
+   reuses these before asking palloc for a fresh zeroed page;
+   init_thread() clears the `struct thread' header, and the rest
+   of the page is kernel stack that need not be zeroed.  Only
+   accessed with interrupts off. */
+#define THREAD_PAGE_CACHE_SIZE 8
+static void *thread_page_cache[THREAD_PAGE_CACHE_SIZE];
+static size_t thread_page_cache_cnt;
+static long long thread_page_cache_hits;   /* # of pages taken from cache. */
+static long long thread_page_cache_misses; /* # of pages from palloc. */
+
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
@@ -65,6 +112,10 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use the fair-share scheduler.
+   Controlled by kernel command-line option "-fair". */
+bool thread_fair;
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -72,6 +123,17 @@ static struct thread *running_thread (void);
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
 static bool is_thread (struct thread *) UNUSED;
+static bool fair_less (const struct rb_elem *, const struct rb_elem *,
+                       void *aux);
+static void fair_enqueue (struct thread *, bool waking);
+static void fair_update_min_vruntime (void);
+static bool sort_locks_by_max_priority (const struct rb_elem *,
+                                        const struct rb_elem *, void *aux);
+static bool update_priority (struct thread *);
+static struct thread *alloc_thread_page (void);
+static void free_thread_page (struct thread *);
+static struct list *tid_bucket (tid_t tid);
+static void tid_table_insert (struct thread *);
                                         static void *alloc_frame (struct thread *, size_t size);
                                         static void schedule (void);
                                         void thread_schedule_tail (struct thread *prev);
@@ -99,7 +161,13 @@ static bool is_thread (struct thread *) UNUSED;
 
   lock_init (&tid_lock);
   list_init (&all_list);
-  if (!thread_mlfqs) // Priority scheduling
+  for (int i = 0; i < TID_BUCKET_CNT; i++)
+    list_init (&tid_buckets[i]);
+  if (thread_fair) // Fair-share scheduling
+  {
+    rb_init (&fair_tree, fair_less, NULL);
+  }
+  else if (!thread_mlfqs) // Priority scheduling
   {
     list_init (&ready_list);
   }
@@ -116,6 +184,7 @@ static bool is_thread (struct thread *) UNUSED;
   init_thread (initial_thread, "main", PRI_DEFAULT);
   initial_thread->status = THREAD_RUNNING;
   initial_thread->tid = allocate_tid ();
+  tid_table_insert (initial_thread);
 }
 
 /* Starts preemptive thread scheduling by enabling interrupts.
@@ -142,7 +211,11 @@ threads_ready (void)
 {
   enum intr_level old_level = intr_disable ();
   size_t ready_thread_count = 0;
-  if (!thread_mlfqs) // Priority scheduling
+  if (thread_fair) // Fair-share scheduling
+  {
+    ready_thread_count = rb_size (&fair_tree);
+  }
+  else if (!thread_mlfqs) // Priority scheduling
   {
     ready_thread_count = list_size (&ready_list);
   }
@@ -180,6 +253,13 @@ thread_tick (void)
   else
     kernel_ticks++;
 
+  /* Charge the tick to the running thread's weighted run time. */
+  if (thread_fair && t != idle_thread)
+  {
+    t->vruntime += FAIR_NICE_0_WEIGHT * FAIR_NICE_0_WEIGHT / t->weight;
+    fair_update_min_vruntime ();
+  }
+
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
     /* Maybe worth checking later if there are no threads in the
@@ -194,6 +274,8 @@ thread_print_stats (void)
 {
   printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
           idle_ticks, kernel_ticks, user_ticks);
+  printf ("Thread page cache: %lld hits, %lld misses\n",
+          thread_page_cache_hits, thread_page_cache_misses);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -225,13 +307,14 @@ thread_create (const char *name, int priority,
   ASSERT (function != NULL);
 
   /* Allocate thread. */
-  t = palloc_get_page (PAL_ZERO);
+  t = alloc_thread_page ();
   if (t == NULL)
     return TID_ERROR;
 
   /* Initialize thread. */
   init_thread (t, name, priority);
   tid = t->tid = allocate_tid ();
+  tid_table_insert (t);
 
   /* Prepare thread for first run by initializing its stack.
      Do this atomically so intermediate values for the 'stack'
@@ -299,7 +382,11 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  if (!thread_mlfqs) // Priority scheduling
+  if (thread_fair) // Fair-share scheduling
+  {
+    fair_enqueue (t, true);
+  }
+  else if (!thread_mlfqs) // Priority scheduling
   {
     list_insert_ordered (
             &ready_list, &t->elem, sort_threads_by_priority, NULL
@@ -362,6 +449,7 @@ thread_exit (void)
      when it calls thread_schedule_tail(). */
   intr_disable ();
   list_remove (&thread_current()->allelem);
+  list_remove (&thread_current()->tidelem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
   NOT_REACHED ();
@@ -380,7 +468,11 @@ thread_yield (void)
   old_level = intr_disable ();
   if (cur != idle_thread)
   {
-    if (!thread_mlfqs) // Priority scheduling
+    if (thread_fair) // Fair-share scheduling
+    {
+      fair_enqueue (cur, false);
+    }
+    else if (!thread_mlfqs) // Priority scheduling
     {
       list_insert_ordered (
               &ready_list, &cur->elem, sort_threads_by_priority, NULL
@@ -413,12 +505,15 @@ thread_foreach (thread_action_func *func, void *aux)
   }
 }
 
-/* Returns a pointer to the thread corresponding to the tid */
+/* Returns a pointer to the thread corresponding to the tid, or
+   NULL if no live thread has that tid.  Only the tid's bucket in
+   tid_buckets is searched. */
 struct thread *get_thread_by_tid(tid_t tid) {
   ASSERT (intr_get_level () == INTR_OFF);
 
-  for (struct list_elem *e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
-    struct thread *t = list_entry(e, struct thread, allelem);
+  struct list *bucket = tid_bucket (tid);
+  for (struct list_elem *e = list_begin(bucket); e != list_end(bucket); e = list_next(e)) {
+    struct thread *t = list_entry(e, struct thread, tidelem);
     if (t->tid == tid) {
       return t;
     }
@@ -431,23 +526,13 @@ void thread_set_priority(int new_priority) {
   struct thread *current_thread = thread_current();
   enum intr_level old_level = intr_disable();
 
-  // Update the base priority.
+  // Update the base priority and the effective priority, which keeps any
+  // larger donation.
   current_thread->base_priority = new_priority;
-
-  // Updates the effective priority based on donations or base priority.
-  if (list_empty(&current_thread->donor_threads) || new_priority > current_thread->priority) {
-    current_thread->priority = new_priority;
-  }
-  int max_priority;
-  if (!list_empty(&current_thread->donor_threads)) {
-    max_priority = list_entry(list_front(&current_thread->donor_threads), struct thread, donor_list_elem)->priority;
-    if (max_priority > new_priority) {
-      current_thread->priority = max_priority;
-    }
-  }
+  update_priority(current_thread);
 
   // Check if we need to yield the CPU.
-  if (!list_empty(&ready_list)) {
+  if (!thread_fair && !list_empty(&ready_list)) {
     struct thread *next_thread = list_entry(list_front(&ready_list), struct thread, elem);
     if (next_thread->priority > thread_get_priority()) {
       // Yield if the next thread in the ready list has a higher priority.
@@ -517,7 +602,10 @@ thread_set_nice (int nice UNUSED)
   struct thread *cur_thread = thread_current ();
   cur_thread->prev_nice = cur_thread->nice;
   cur_thread->nice = nice;
-  calc_prio_sort_action (cur_thread, NULL);
+  if (thread_fair)
+    cur_thread->weight = fair_weights[nice - NICE_MIN];
+  else
+    calc_prio_sort_action (cur_thread, NULL);
   intr_set_level (old_level);
   thread_yield ();
 }
@@ -556,7 +644,8 @@ thread_get_recent_cpu (void)
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
-   special case when the ready list is empty. */
+   special case when the ready list is empty.  Whenever it runs,
+   it first refills the page allocator's pre-zeroed pages. */
 static void
 idle (void *idle_started_ UNUSED)
 {
@@ -566,6 +655,13 @@ idle (void *idle_started_ UNUSED)
 
   for (;;)
   {
+    /* Zero free pages for later PAL_ZERO requests while there is
+       nothing else to do.  Interrupts are on, so a thread that
+       becomes ready preempts us as soon as its interrupt
+       returns. */
+    while (palloc_prezero_page ())
+      continue;
+
     /* Let someone else run. */
     intr_disable ();
     thread_block ();
@@ -654,10 +750,16 @@ init_thread (struct thread *t, const char *name, int priority)
     t->prev_priority = -1;
     t->priority = calc_prio (t);
   }
+  if (thread_fair)   /* Fair-share scheduling initialisation */
+  {
+    t->nice = INIT_NICE;
+    t->weight = fair_weights[t->nice - NICE_MIN];
+    t->vruntime = fair_min_vruntime;
+  }
   t->lock_waiting_for = NULL;
   t->magic = THREAD_MAGIC;
-  list_init(&t->donor_threads);
-  list_init(&t->children_list);
+  rb_init(&t->held_locks, sort_locks_by_max_priority, NULL);
+  intmap_init(&t->children);
   t->next_fd = 2;
   old_level = intr_disable ();
   list_push_back (&all_list, &t->allelem);
@@ -685,7 +787,14 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void)
 {
-  if (!thread_mlfqs) // Priority scheduling
+  if (thread_fair) // Fair-share scheduling
+  {
+    if (rb_empty (&fair_tree))
+      return idle_thread;
+    else
+      return rb_entry (rb_pop_min (&fair_tree), struct thread, fair_elem);
+  }
+  else if (!thread_mlfqs) // Priority scheduling
   {
     if (list_empty (&ready_list))
       return idle_thread;
@@ -749,7 +858,7 @@ thread_schedule_tail (struct thread *prev)
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread)
   {
     ASSERT (prev != cur);
-    palloc_free_page (prev);
+    free_thread_page (prev);
   }
 }
 
@@ -772,7 +881,10 @@ schedule (void)
   ASSERT (is_thread (next));
 
   if (cur != next)
-    prev = switch_threads (cur, next);
+    {
+      trace (TRACE_SWITCH, TRACE_INSTANT, next->tid, cur->status);
+      prev = switch_threads (cur, next);
+    }
   thread_schedule_tail (prev);
 }
 
@@ -790,6 +902,115 @@ allocate_tid (void)
   return tid;
 }
 
+/* Orders threads in fair_tree by ascending vruntime. */
+static bool
+fair_less (const struct rb_elem *a_, const struct rb_elem *b_,
+           void *aux UNUSED)
+{
+  const struct thread *a = rb_entry (a_, struct thread, fair_elem);
+  const struct thread *b = rb_entry (b_, struct thread, fair_elem);
+  return a->vruntime < b->vruntime;
+}
+
+/* Adds T to the fair-share run tree.  If T is WAKING up after
+   being blocked, its vruntime is first raised to within
+   FAIR_SLEEPER_CREDIT time slices of fair_min_vruntime, so that
+   a thread that slept for a long time gets to run soon but
+   cannot then monopolise the CPU to catch up.
+   Must be called with interrupts off. */
+static void
+fair_enqueue (struct thread *t, bool waking)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (waking)
+  {
+    int64_t floor;
+
+    fair_update_min_vruntime ();
+    floor = fair_min_vruntime
+            - (int64_t) FAIR_SLEEPER_CREDIT * TIME_SLICE * FAIR_NICE_0_WEIGHT;
+    if (t->vruntime < floor)
+      t->vruntime = floor;
+  }
+  rb_insert (&fair_tree, &t->fair_elem);
+}
+
+/* Advances fair_min_vruntime to the smallest vruntime among the
+   running thread and the threads in fair_tree. */
+static void
+fair_update_min_vruntime (void)
+{
+  struct thread *cur = running_thread ();
+  int64_t min = INT64_MAX;
+
+  if (cur != idle_thread && cur->status == THREAD_RUNNING)
+    min = cur->vruntime;
+  if (!rb_empty (&fair_tree))
+  {
+    struct thread *t = rb_entry (rb_min (&fair_tree), struct thread,
+                                 fair_elem);
+    if (t->vruntime < min)
+      min = t->vruntime;
+  }
+  if (min != INT64_MAX && min > fair_min_vruntime)
+    fair_min_vruntime = min;
+}
+
+/* Returns a page for a new thread, taking one from
+   thread_page_cache if possible.  Only the `struct thread' at the
+   bottom of the page is guaranteed to be usable: init_thread()
+   must be called on it before anything else. */
+static struct thread *
+alloc_thread_page (void)
+{
+  struct thread *t = NULL;
+  enum intr_level old_level = intr_disable ();
+  if (thread_page_cache_cnt > 0)
+  {
+    t = thread_page_cache[--thread_page_cache_cnt];
+    thread_page_cache_hits++;
+  }
+  else
+    thread_page_cache_misses++;
+  intr_set_level (old_level);
+
+  if (t == NULL)
+    t = palloc_get_page (PAL_ZERO);
+  return t;
+}
+
+/* Releases the page of dying thread T, keeping it in
+   thread_page_cache if there is room.
+   Must be called with interrupts off. */
+static void
+free_thread_page (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (thread_page_cache_cnt < THREAD_PAGE_CACHE_SIZE)
+    thread_page_cache[thread_page_cache_cnt++] = t;
+  else
+    palloc_free_page (t);
+}
+
+/* Returns the tid_buckets chain that holds TID. */
+static struct list *
+tid_bucket (tid_t tid)
+{
+  return &tid_buckets[(unsigned) tid % TID_BUCKET_CNT];
+}
+
+/* Adds T, whose tid has just been allocated, to the tid lookup
+   table.  It is removed again by thread_exit(). */
+static void
+tid_table_insert (struct thread *t)
+{
+  enum intr_level old_level = intr_disable ();
+  list_push_back (tid_bucket (t->tid), &t->tidelem);
+  intr_set_level (old_level);
+}
+
 /* Offset of `stack' member within `struct thread'.
    Used by switch.S, which can't figure it out on its own. */
 uint32_t thread_stack_ofs = offsetof (struct thread, stack);
@@ -804,82 +1025,92 @@ bool sort_threads_by_priority (
   return a->priority > b->priority;
 }
 
-static bool sort_threads_by_donor_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED) {
-  const struct thread *a = list_entry(a_, struct thread, donor_list_elem);
-  const struct thread *b = list_entry(b_, struct thread, donor_list_elem);
-  return a->priority > b->priority;
+/* Orders a thread's held_locks tree so that the lock with the
+   highest-priority waiter comes first. */
+static bool sort_locks_by_max_priority(const struct rb_elem *a_, const struct rb_elem *b_, void *aux UNUSED) {
+  const struct lock *a = rb_entry(a_, struct lock, held_elem);
+  const struct lock *b = rb_entry(b_, struct lock, held_elem);
+  return a->max_priority > b->max_priority;
 }
 
-/* Adds donations to the lock holder, recursively increasing priority further if it also waits on the lock */
-void donate_priority(struct lock *lock) {
-  struct thread *thread = lock->holder;
-  struct thread *curr = thread_current();
-  while (thread != NULL) {
-    if (curr->priority > thread->priority) {
-      thread->priority = curr->priority;
-      if (!is_interior(&curr->donor_list_elem)) {
-        list_insert_ordered(&thread->donor_threads, &curr->donor_list_elem, sort_threads_by_donor_priority, NULL);
-      }
+/* Recomputes T's effective priority as the larger of its base
+   priority and the highest priority waiting on any lock it holds.
+   Returns true if the effective priority changed.  Must be called
+   with interrupts off. */
+static bool update_priority(struct thread *t) {
+  ASSERT (intr_get_level () == INTR_OFF);
 
-      if (thread->lock_waiting_for != NULL) {
-        thread = thread->lock_waiting_for->holder;
-      } else {
-        break;
-      }
+  if (thread_mlfqs) {
+    return false;
+  }
+  int old_priority = t->priority;
+  int new_priority = t->base_priority;
+  if (!rb_empty(&t->held_locks)) {
+    struct lock *top = rb_entry(rb_min(&t->held_locks), struct lock, held_elem);
+    if (top->max_priority > new_priority) {
+      new_priority = top->max_priority;
     }
   }
+  t->priority = new_priority;
+
+  // Keep the ready list ordered if T is waiting to run.
+  if (new_priority != old_priority && t->status == THREAD_READY && !thread_fair) {
+    list_remove(&t->elem);
+    list_insert_ordered(&ready_list, &t->elem, sort_threads_by_priority, NULL);
+  }
+  return new_priority != old_priority;
 }
 
-/* Removes donations from any thread waiting on lock 'lock' and update's the threads effective priority */
-void remove_priority(struct lock *lock) {
-  struct thread *curr = thread_current();
+/* Donates the current thread's priority to the holder of 'lock', which it is
+   about to wait on, and on down the chain of holders that are themselves
+   waiting for locks.  Each lock remembers its highest-priority waiter and
+   each holder finds its largest donation at the front of its held_locks, so
+   every step of the chain costs O(log held locks).  Stops as soon as a holder's
+   effective priority is unaffected. */
+void donate_priority(struct lock *lock) {
+  enum intr_level old_level = intr_disable();
+  int priority = thread_current()->priority;
+  while (lock != NULL && lock->holder != NULL && priority > lock->max_priority) {
+    struct thread *holder = lock->holder;
 
-  struct list *donor_list = &curr->donor_threads;
-  struct list_elem *e = list_begin(donor_list);
-  bool found = false;
-  struct thread *donee_thread;
-  // Finding the donee thread and remove it from the donor_list
-  while (e != list_end(donor_list)) {
-    struct thread *thread = list_entry(e, struct thread, donor_list_elem);
-    if (thread->lock_waiting_for == lock) {
-      if (!found) {
-        donee_thread = thread;
-        e = list_remove(e);
-      } else {
-        break;
-      }
-      found = true;
-    } else {
-      e = list_next(e);
+    // Re-key the lock in its holder's tree with the new max waiter priority.
+    rb_remove(&holder->held_locks, &lock->held_elem);
+    lock->max_priority = priority;
+    rb_insert(&holder->held_locks, &lock->held_elem);
+
+    if (!update_priority(holder)) {
+      break;
     }
+    priority = holder->priority;
+    lock = holder->lock_waiting_for;
   }
-  // If donee thread exists, move all donor threads waiting for same lock to the donee thread
-  if (found) {
-    e = list_begin(donor_list);
-    while (e != list_end(donor_list)) {
-      struct thread *thread = list_entry(e, struct thread, donor_list_elem);
-      if (thread->lock_waiting_for == lock) {
-        e = list_remove(e);
-        list_insert_ordered(&donee_thread->donor_threads, &thread->donor_list_elem, sort_threads_by_donor_priority, NULL);
-      } else {
-        e = list_next(e);
-      }
-    }
-    // Updating priority of the current thread
-    int highest_priority = curr->base_priority;
-    if (!list_empty(donor_list)) {
-      struct thread *t = list_entry(list_front(donor_list), struct thread, donor_list_elem);
-      int max_priority = t->priority;
-      if (max_priority > curr->base_priority) {
-        highest_priority = max_priority;
-      }
-    }
-    curr->priority = highest_priority;
+  intr_set_level(old_level);
+}
+
+/* Makes the current thread, which has just downed the semaphore of 'lock',
+   its holder.  Threads still waiting on the lock now donate to the current
+   thread instead of to the previous holder. */
+void hold_lock(struct lock *lock) {
+  struct thread *curr = thread_current();
+  enum intr_level old_level = intr_disable();
+
+  lock->holder = curr;
+  lock->max_priority = PRI_MIN - 1;
+  if (!list_empty(&lock->semaphore.waiters)) {
+    struct thread *t = list_entry(list_min(&lock->semaphore.waiters, sort_threads_by_priority, NULL), struct thread, elem);
+    lock->max_priority = t->priority;
   }
+  rb_insert(&curr->held_locks, &lock->held_elem);
+  update_priority(curr);
+  intr_set_level(old_level);
 }
 
-/* Copied from list.c*/
-bool is_interior (struct list_elem *elem)
-{
-  return elem->prev != NULL && elem->next != NULL;
-}
\ No newline at end of file
+/* Removes the donations received through 'lock', which the current thread is
+   about to release, and updates the thread's effective priority. */
+void remove_priority(struct lock *lock) {
+  struct thread *curr = thread_current();
+  enum intr_level old_level = intr_disable();
+  rb_remove(&curr->held_locks, &lock->held_elem);
+  update_priority(curr);
+  intr_set_level(old_level);
+}
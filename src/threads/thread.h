@@ -7,6 +7,8 @@
 #include "threads/fixed-point-arith.h"
 #include "synch.h"
 #include "lib/kernel/hash.h"
+#include "lib/kernel/intmap.h"
+#include "lib/kernel/rbtree.h"
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -42,6 +44,11 @@ typedef int tid_t;
 // Initial load_avg at boot
 #define INIT_LOAD_AVG 0
 
+/* Fair-share scheduler constants */
+#define FAIR_NICE_0_WEIGHT 1024         /* Weight of a thread with nice 0. */
+#define FAIR_SLEEPER_CREDIT 2           /* Time slices of vruntime credit
+                                           a waking thread may keep. */
+
 // Initial exit status
 #define INIT_EXIT_STATUS -2
 
@@ -108,9 +115,8 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    struct list donor_threads;          /* List of threads that have donated 
-                                           their priorities*/
-    struct list_elem donor_list_elem;   /* list elem for donor_threads list */
+    struct rb_tree held_locks;          /* Locks held, highest waiter 
+                                           priority first */
     int priority;                       /* Effective priority. */
     int prev_priority;                  /* Previous priority. */
     int base_priority;                  /* Base priority */
@@ -118,17 +124,24 @@ struct thread
     int prev_nice;                      /* Thread's previous nice */
     fixed_point recent_cpu;             /* Thread's estimated recent CPU time */
     fixed_point prev_recent_cpu;        /* Thread's previous recent_cpu */
+    int weight;                         /* Fair-share weight, from nice */
+    int64_t vruntime;                   /* Fair-share weighted run time */
+    struct rb_elem fair_elem;           /* Element in fair-share run tree */
     struct lock *lock_waiting_for;      /* Lock the thread is waiting for*/
     struct list_elem allelem;           /* List element for all threads list. */
+    struct list_elem tidelem;           /* List element for tid lookup table. */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
+    struct rwlock_hold read_holds[RWLOCK_READ_MAX];
+                                        /* Reader-writer locks held for
+                                           reading. */
 
     /* Task 2 implementation fields */
     struct hash fd_hash_table;          /* Hash table of file descriptors */
     int next_fd;                        /* Stores next available fd number */
 
-    struct list children_list;          /* List of child_info structs of this thread */
+    struct intmap children;             /* child_info structs of this thread, by tid */
     struct child_info *my_info;         /* Info about this thread */
 
     struct file *executable;            /* Stores executable of current process */
@@ -136,8 +149,12 @@ struct thread
     /* Task 3 implementation fields */
     struct hash spt;                    /* Supplemental page table */
 
-    struct hash mmap_hash_table;        /* Hash table of memory mapped files */
+    struct intmap mmap_table;           /* Memory mapped files, by mapid */
     mapid_t next_mapid;                 /* Stores next available mapid  */
+    void *user_esp;                     /* User stack pointer at syscall entry */
+    struct ring *ring;                  /* I/O ring, or null */
+    void *heap_start;                   /* Start of the heap */
+    void *brk;                          /* End of the heap, the break */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
@@ -155,6 +172,10 @@ extern fixed_point load_avg;
    Controlled by kernel command-line option "mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the fair-share (virtual runtime) scheduler.
+   Controlled by kernel command-line option "fair". */
+extern bool thread_fair;
+
 void thread_init (void);
 void thread_start (void);
 size_t threads_ready(void);
@@ -194,11 +215,11 @@ bool sort_threads_by_priority(
 );
 
 void donate_priority(struct lock *lock);
+void hold_lock(struct lock *lock);
 void remove_priority(struct lock *lock);
 
 void calc_prio_sort_action (struct thread* t, void *aux UNUSED);
 
 bool is_idle_thread(void);
-bool is_interior (struct list_elem *elem);
 
 #endif /* threads/thread.h */
\ No newline at end of file
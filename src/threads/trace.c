@@ -0,0 +1,198 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <rdtsc.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Kernel event tracing.
+
+   The "-trace" option turns on trace points in the scheduler,
+   system call handler, page fault handler, frame eviction, swap
+   and IDE driver.  Each event is appended as a fixed-size binary
+   record to a ring buffer, overwriting the oldest once it is
+   full.  Recording takes a few dozen instructions with
+   interrupts disabled; a trace point whose category is off costs
+   a load and a test (see trace() in trace.h).
+
+   At shutdown the records are printed one per line, as
+   "Trace event:" followed by the TSC, tid, phase, event name and
+   arguments, after a header that relates TSC cycles to timer
+   ticks.  utils/trace2json turns that output into a Chrome trace
+   file for viewing in chrome://tracing or Perfetto. */
+
+/* Number of pages in the ring buffer. */
+#define TRACE_PAGES 64
+
+/* One event. */
+struct trace_rec
+  {
+    uint64_t tsc;               /* Time-stamp counter. */
+    int32_t tid;                /* Thread that recorded the event. */
+    uint16_t event;             /* enum trace_event. */
+    uint8_t phase;              /* enum trace_phase. */
+    uint32_t arg0, arg1;        /* Event-specific arguments. */
+  };
+
+/* Names of the categories, as given to "-trace". */
+static const char *category_names[TRACE_CATEGORY_CNT] =
+  {"sched", "syscall", "vm", "swap", "disk"};
+
+unsigned trace_categories;
+
+static unsigned configured;     /* Categories requested. */
+static struct trace_rec *recs;  /* Ring buffer, or null. */
+static size_t rec_cap;          /* Number of records in the ring. */
+static size_t rec_next;         /* Ring index of the next record. */
+static int64_t rec_cnt;         /* Number of records ever made. */
+static uint64_t start_tsc;      /* TSC when tracing started. */
+static int64_t start_ticks;     /* Timer ticks when tracing started. */
+
+static const char *event_name (enum trace_event);
+
+/* Selects the categories named in CATEGORIES, a comma-separated
+   list, or all of them if CATEGORIES is null or "all".  Called
+   while parsing the command line; trace_init() then starts
+   tracing.  Returns false if a name is not recognized. */
+bool
+trace_configure (const char *categories)
+{
+  char buf[64];
+  char *name, *save_ptr;
+
+  if (categories == NULL || !strcmp (categories, "all"))
+    {
+      configured = (1u << TRACE_CATEGORY_CNT) - 1;
+      return true;
+    }
+
+  strlcpy (buf, categories, sizeof buf);
+  for (name = strtok_r (buf, ",", &save_ptr); name != NULL;
+       name = strtok_r (NULL, ",", &save_ptr))
+    {
+      int i;
+
+      for (i = 0; i < TRACE_CATEGORY_CNT; i++)
+        if (!strcmp (name, category_names[i]))
+          break;
+      if (i == TRACE_CATEGORY_CNT)
+        return false;
+      configured |= 1u << i;
+    }
+  return true;
+}
+
+/* Allocates the ring buffer and enables the trace points of the
+   configured categories. */
+void
+trace_init (void)
+{
+  struct trace_rec *buf;
+
+  if (configured == 0)
+    return;
+
+  buf = palloc_get_multiple (0, TRACE_PAGES);
+  if (buf == NULL)
+    {
+      printf ("trace: could not allocate trace buffer\n");
+      return;
+    }
+  rec_cap = TRACE_PAGES * PGSIZE / sizeof *recs;
+  recs = buf;
+  start_tsc = rdtsc ();
+  start_ticks = timer_ticks ();
+  trace_categories = configured;
+}
+
+/* Appends an event to the ring buffer.  Use trace() instead,
+   which skips the call for categories that are off. */
+void
+trace_record (enum trace_event event, enum trace_phase phase,
+              uint32_t arg0, uint32_t arg1)
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (recs != NULL)
+    {
+      /* thread_current() insists that the thread be running,
+         which is not yet or no longer true at a context switch,
+         so find the thread from the stack pointer directly. */
+      uint8_t *esp;
+      struct thread *t;
+      struct trace_rec *r;
+
+      asm ("mov %%esp, %0" : "=g" (esp));
+      t = pg_round_down (esp);
+
+      r = &recs[rec_next];
+      rec_next = (rec_next + 1) % rec_cap;
+      rec_cnt++;
+
+      r->tsc = rdtsc ();
+      r->tid = t->tid;
+      r->event = event;
+      r->phase = phase;
+      r->arg0 = arg0;
+      r->arg1 = arg1;
+    }
+
+  intr_set_level (old_level);
+}
+
+/* Stops tracing and prints the records in the ring buffer,
+   oldest first. */
+void
+trace_dump (void)
+{
+  enum intr_level old_level;
+  struct trace_rec *buf;
+  size_t cnt, i;
+
+  /* Detach the buffer so that no event is recorded mid-dump. */
+  old_level = intr_disable ();
+  buf = recs;
+  recs = NULL;
+  trace_categories = 0;
+  intr_set_level (old_level);
+  if (buf == NULL)
+    return;
+
+  cnt = rec_cnt < (int64_t) rec_cap ? rec_cnt : rec_cap;
+  printf ("Trace: %"PRId64" events, %"PRId64" overwritten, "
+          "%"PRIu64" cycles in %"PRId64" ticks at %d Hz.\n",
+          rec_cnt, rec_cnt - (int64_t) cnt,
+          rdtsc () - start_tsc, timer_elapsed (start_ticks), TIMER_FREQ);
+  for (i = 0; i < cnt; i++)
+    {
+      const struct trace_rec *r
+        = &buf[(rec_next + rec_cap - cnt + i) % rec_cap];
+
+      printf ("Trace event: %"PRIu64" %"PRId32" %c %s %#"PRIx32" %#"PRIx32"\n",
+              r->tsc - start_tsc, r->tid, r->phase, event_name (r->event),
+              r->arg0, r->arg1);
+    }
+}
+
+/* Returns the name of EVENT. */
+static const char *
+event_name (enum trace_event event)
+{
+  switch (event)
+    {
+    case TRACE_SWITCH: return "switch";
+    case TRACE_SYSCALL_CALL: return "syscall";
+    case TRACE_PAGE_FAULT: return "page_fault";
+    case TRACE_EVICT: return "evict";
+    case TRACE_SWAP_OUT: return "swap_out";
+    case TRACE_SWAP_IN: return "swap_in";
+    case TRACE_DISK_READ: return "disk_read";
+    case TRACE_DISK_WRITE: return "disk_write";
+    }
+  return "unknown";
+}
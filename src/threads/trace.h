@@ -0,0 +1,60 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Event categories, selected with the "-trace" option. */
+enum trace_category
+  {
+    TRACE_SCHED,                /* Context switches. */
+    TRACE_SYSCALL,              /* System calls. */
+    TRACE_VM,                   /* Page faults and frame eviction. */
+    TRACE_SWAP,                 /* Swap I/O. */
+    TRACE_DISK,                 /* IDE disk I/O. */
+    TRACE_CATEGORY_CNT
+  };
+
+/* Event types.  The category of each is its value divided by
+   16. */
+enum trace_event
+  {
+    TRACE_SWITCH = TRACE_SCHED * 16,    /* Next tid, old status. */
+    TRACE_SYSCALL_CALL = TRACE_SYSCALL * 16, /* Number; eax at end. */
+    TRACE_PAGE_FAULT = TRACE_VM * 16,   /* Address, error code. */
+    TRACE_EVICT,                        /* Victim upage, frame. */
+    TRACE_SWAP_OUT = TRACE_SWAP * 16,   /* Frame, slot. */
+    TRACE_SWAP_IN,                      /* Frame, slot. */
+    TRACE_DISK_READ = TRACE_DISK * 16,  /* Sector. */
+    TRACE_DISK_WRITE                    /* Sector. */
+  };
+
+/* How an event relates to the ones around it. */
+enum trace_phase
+  {
+    TRACE_BEGIN = 'B',          /* Start of a span on this thread. */
+    TRACE_END = 'E',            /* End of the innermost span. */
+    TRACE_INSTANT = 'i'         /* A point in time. */
+  };
+
+/* Bit N is set if category N is being traced. */
+extern unsigned trace_categories;
+
+bool trace_configure (const char *categories);
+void trace_init (void);
+void trace_record (enum trace_event, enum trace_phase,
+                   uint32_t arg0, uint32_t arg1);
+void trace_dump (void);
+
+/* Records EVENT with PHASE and arguments ARG0 and ARG1, if its
+   category is being traced.  When it is not, this costs a load
+   and a test. */
+static inline void
+trace (enum trace_event event, enum trace_phase phase,
+       uint32_t arg0, uint32_t arg1)
+{
+  if (trace_categories & (1u << (event / 16)))
+    trace_record (event, phase, arg0, arg1);
+}
+
+#endif /* threads/trace.h */
@@ -0,0 +1,156 @@
+#include "threads/vmalloc.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdint.h>
+#include "threads/loader.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Virtually contiguous kernel allocations.
+
+   palloc_get_multiple() needs physically contiguous free pages,
+   which a fragmented kernel pool may lack even when plenty of
+   pages are free.  The allocator here takes single pages from
+   the kernel pool and maps them at consecutive addresses in a
+   range of kernel virtual memory reserved for the purpose, so a
+   multi-page request succeeds whenever enough pages are free.
+
+   Every process's page directory is a copy of the kernel's, made
+   by pagedir_create(), so the page tables covering the range are
+   all created at boot time.  Later mappings only change entries
+   in those shared page tables, which makes them visible in every
+   address space at once.
+
+   Each allocation is followed by an unmapped guard page, so that
+   running off the end of one faults instead of corrupting the
+   next.  Memory obtained here has no physical alias in the
+   direct mapping at a predictable address, so it must not be
+   passed to vtop(). */
+
+/* Number of page tables that cover the range. */
+#define VMALLOC_PT_CNT (VMALLOC_PAGES / (PGSIZE / sizeof (uint32_t)))
+
+/* Page table entries for the range, one per page, in order.
+   The range's page tables are contiguous, so this is a single
+   array. */
+static uint32_t *vmalloc_ptes;
+
+/* Pages of the range in use, including guard pages. */
+static struct bitmap *used_map;
+static uint8_t used_map_buf[VMALLOC_PAGES / 8 + 32]; /* Bits + header. */
+static struct lock vmalloc_lock;
+
+static void invalidate_page (void *);
+
+/* Reserves the vmalloc range in page directory PD, which must be
+   the kernel's initial page directory, by creating all the page
+   tables that cover it. */
+void
+vmalloc_init (uint32_t *pd)
+{
+  uint8_t *vaddr = VMALLOC_START;
+  size_t i;
+
+  ASSERT ((uint8_t *) ptov (init_ram_pages * PGSIZE) <= vaddr);
+  ASSERT (pd_no (vaddr) + VMALLOC_PT_CNT <= pd_no ((void *) 0xffffffff));
+
+  vmalloc_ptes = palloc_get_multiple (PAL_ASSERT | PAL_ZERO,
+                                      VMALLOC_PT_CNT);
+  for (i = 0; i < VMALLOC_PT_CNT; i++)
+    pd[pd_no (vaddr) + i] = pde_create (vmalloc_ptes
+                                        + i * (PGSIZE / sizeof (uint32_t)));
+
+  used_map = bitmap_create_in_buf (VMALLOC_PAGES, used_map_buf,
+                                   sizeof used_map_buf);
+  lock_init (&vmalloc_lock);
+}
+
+/* Obtains PAGE_CNT free pages from the kernel pool, maps them at
+   consecutive addresses in the vmalloc range, and returns the
+   address of the first.  The pages need not be physically
+   contiguous.  Returns a null pointer if too few pages are free
+   or the range is exhausted. */
+void *
+vmalloc_get_multiple (size_t page_cnt)
+{
+  size_t page_idx, i;
+
+  if (page_cnt == 0)
+    return NULL;
+
+  lock_acquire (&vmalloc_lock);
+  page_idx = bitmap_scan_and_flip (used_map, 0, page_cnt + 1, false);
+  lock_release (&vmalloc_lock);
+  if (page_idx == BITMAP_ERROR)
+    return NULL;
+
+  for (i = 0; i < page_cnt; i++)
+    {
+      void *kpage = palloc_get_page (0);
+      if (kpage == NULL)
+        {
+          vmalloc_free_multiple ((uint8_t *) VMALLOC_START
+                                 + page_idx * PGSIZE, i);
+
+          /* vmalloc_free_multiple() released only the I pages
+             mapped so far, plus one guard page. */
+          lock_acquire (&vmalloc_lock);
+          bitmap_set_multiple (used_map, page_idx + i + 1, page_cnt - i,
+                               false);
+          lock_release (&vmalloc_lock);
+          return NULL;
+        }
+      ASSERT (vmalloc_ptes[page_idx + i] == 0);
+      vmalloc_ptes[page_idx + i] = pte_create_kernel (kpage, true);
+    }
+
+  return (uint8_t *) VMALLOC_START + page_idx * PGSIZE;
+}
+
+/* Unmaps and frees the PAGE_CNT pages starting at PAGES, which
+   must have been returned by vmalloc_get_multiple() for the same
+   PAGE_CNT. */
+void
+vmalloc_free_multiple (void *pages, size_t page_cnt)
+{
+  size_t page_idx, i;
+
+  ASSERT (pg_ofs (pages) == 0);
+  ASSERT (is_vmalloc_vaddr (pages));
+
+  page_idx = ((uint8_t *) pages - (uint8_t *) VMALLOC_START) / PGSIZE;
+  for (i = 0; i < page_cnt; i++)
+    {
+      uint32_t *pte = &vmalloc_ptes[page_idx + i];
+      void *vaddr = (uint8_t *) pages + i * PGSIZE;
+
+      ASSERT (*pte & PTE_P);
+      palloc_free_page (pte_get_page (*pte));
+      *pte = 0;
+      invalidate_page (vaddr);
+    }
+
+  lock_acquire (&vmalloc_lock);
+  ASSERT (bitmap_all (used_map, page_idx, page_cnt + 1));
+  bitmap_set_multiple (used_map, page_idx, page_cnt + 1, false);
+  lock_release (&vmalloc_lock);
+}
+
+/* Returns true if VADDR lies in the vmalloc range, false
+   otherwise. */
+bool
+is_vmalloc_vaddr (const void *vaddr)
+{
+  return (const uint8_t *) vaddr >= (const uint8_t *) VMALLOC_START
+         && (const uint8_t *) vaddr < ((const uint8_t *) VMALLOC_START
+                                       + VMALLOC_PAGES * PGSIZE);
+}
+
+/* Removes any TLB entry for the page at VADDR. */
+static void
+invalidate_page (void *vaddr)
+{
+  asm volatile ("invlpg (%0)" : : "r" (vaddr) : "memory");
+}
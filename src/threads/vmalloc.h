@@ -0,0 +1,18 @@
+#ifndef THREADS_VMALLOC_H
+#define THREADS_VMALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Kernel virtual range reserved for vmalloc, above the direct
+   mapping of physical memory. */
+#define VMALLOC_START ((void *) 0xf0000000)
+#define VMALLOC_PAGES 4096              /* 16 MB. */
+
+void vmalloc_init (uint32_t *pd);
+void *vmalloc_get_multiple (size_t page_cnt);
+void vmalloc_free_multiple (void *, size_t page_cnt);
+bool is_vmalloc_vaddr (const void *);
+
+#endif /* threads/vmalloc.h */
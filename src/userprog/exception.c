@@ -3,8 +3,11 @@
 #include <stdio.h>
 #include <string.h>
 #include "userprog/gdt.h"
+#include "threads/flags.h"
 #include "threads/interrupt.h"
+#include "threads/intr-stubs.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "userprog/syscall.h"
 #include "vm/page.h"
 #include "threads/vaddr.h"
@@ -12,13 +15,16 @@
 #include "userprog/process.h"
 #include "devices/serial.h"
 #include "devices/swap.h"
+#include "userprog/uaccess.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
 static void kill (struct intr_frame *);
+static void debug_trap (struct intr_frame *);
 bool is_stack_growth(void *fault_addr, void *esp);
 static void page_fault (struct intr_frame *);
+static bool handle_page_fault (struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
    programs.
@@ -51,7 +57,7 @@ exception_init (void)
      caused indirectly, e.g. #DE can be caused by dividing by
      0.  */
   intr_register_int (0, 0, INTR_ON, kill, "#DE Divide Error");
-  intr_register_int (1, 0, INTR_ON, kill, "#DB Debug Exception");
+  intr_register_int (1, 0, INTR_ON, debug_trap, "#DB Debug Exception");
   intr_register_int (6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
   intr_register_int (7, 0, INTR_ON, kill, "#NM Device Not Available Exception");
   intr_register_int (11, 0, INTR_ON, kill, "#NP Segment Not Present");
@@ -114,11 +120,56 @@ kill (struct intr_frame *f)
     }
 }
 
+/* Handler for #DB.  SYSENTER does not clear the trap flag, so a
+   user program that sets it and then makes a fast system call
+   takes a single-step trap at the kernel's entry point.  Clear
+   the flag and let the system call go on.  Any other debug
+   exception is treated like the rest. */
+static void
+debug_trap (struct intr_frame *f)
+{
+  if (f->cs == SEL_KCSEG && f->eip == syscall_sysenter) {
+    f->eflags &= ~FLAG_TF;
+    return;
+  }
+  kill(f);
+}
+
 bool is_stack_growth(void *fault_addr, void *esp) {
   return (fault_addr < PHYS_BASE) && (fault_addr >= STACK_LIMIT) &&
          (fault_addr >= esp || fault_addr == esp - PUSHA_SIZE || fault_addr == esp - PUSH_SIZE);
 }
 
+/* Handles page fault F with handle_page_fault().  A fault that
+   it cannot resolve kills the process if it came from user code.
+   If it came from one of the kernel's user-memory copy routines
+   (see userprog/uaccess.c), the routine resumes at its fixup and
+   returns failure to its caller, which can then release any
+   locks it holds.  Any other kernel fault is a kernel bug.
+
+   Then marks the end of the fault in the event trace.  Faults
+   that kill the process never return here, so their spans are
+   left open. */
+static void
+page_fault (struct intr_frame *f)
+{
+  if (!handle_page_fault (f)) {
+    bool user = (f->error_code & PF_U) != 0;
+    void *fixup = user ? NULL : uaccess_fixup (f->eip);
+    if (fixup != NULL) {
+      f->eip = fixup;
+    } else if (user) {
+      exit(-1);
+    } else {
+      void *fault_addr;
+      asm ("movl %%cr2, %0" : "=r" (fault_addr));
+      printf ("Page fault at %p in kernel context.\n", fault_addr);
+      kill (f);
+    }
+  }
+  trace (TRACE_PAGE_FAULT, TRACE_END, 0, 0);
+}
+
 /* Page fault handler.  This is a skeleton that must be filled in
    to implement virtual memory.  Some solutions to task 2 may
    also require modifying this code.
@@ -129,9 +180,12 @@ bool is_stack_growth(void *fault_addr, void *esp) {
    example code here shows how to parse that information.  You
    can find more information about both of these in the
    description of "Interrupt 14--Page Fault Exception (#PF)" in
-   [IA32-v3a] section 5.15 "Exception and Interrupt Reference". */
-static void
-page_fault (struct intr_frame *f) 
+   [IA32-v3a] section 5.15 "Exception and Interrupt Reference".
+
+   Returns true if the faulting page was brought in, false if the
+   access was invalid. */
+static bool
+handle_page_fault (struct intr_frame *f) 
 {
   bool not_present;  /* True: not-present page, false: writing r/o page. */
   bool write;        /* True: access was write, false: access was read. */
@@ -146,6 +200,7 @@ page_fault (struct intr_frame *f)
      [IA32-v3a] 5.15 "Interrupt 14--Page Fault Exception
      (#PF)". */
   asm ("movl %%cr2, %0" : "=r" (fault_addr));
+  trace (TRACE_PAGE_FAULT, TRACE_BEGIN, (uintptr_t) fault_addr, f->error_code);
 
   /* Turn interrupts back on (they were only off so that we could
      be assured of reading CR2 before it changed). */
@@ -163,12 +218,9 @@ page_fault (struct intr_frame *f)
      body, and replace it with code that brings in the page to
      which fault_addr refers. */
 
-  // If we reach here, it is an error
+  // Rights violations are always errors
   if (!not_present) {
-    if (lock_held_by_current_thread(&filesystem_lock)) {
-      lock_release(&filesystem_lock);
-    }
-    exit(-1);
+    return false;
   }
   // Rounding down fault_addr for page lookup
   void *fault_page_addr = pg_round_down(fault_addr);
@@ -180,81 +232,53 @@ page_fault (struct intr_frame *f)
             write ? "writing" : "reading",
             user ? "user" : "kernel");
     printf("Invalid address %p found!\n", fault_page_addr);
-    exit(-1);
+    return false;
   }
   struct page *page = spt_lookup(fault_page_addr, &thread_current()->spt);
   if (page != NULL) { // Lazy loading:
-    struct frame_entry *f_entry = frame_alloc(PAL_USER, fault_page_addr);
-    void *frame = f_entry->frame_addr;
-    if (page->swapped) {
-      // Read the page data from the swap partition
-      swap_in(frame, page->swap_slot);
-
-      // Install the page into the page table
-      if (!install_page(page->vaddr, frame, page->writable)) {
-        frame_free(frame);
-        kill(f);
-      }
-      page->frame = frame;
-      page->swap_slot = -1;
-      page->swapped = false;
-      return;
+    if (write && !page->writable) {
+      return false;
     }
-    switch (page->status) {
-      case PAGE_FILE:
-        if (!page->writable && write) {
-          if (lock_held_by_current_thread(&filesystem_lock)) {
-            lock_release(&filesystem_lock);
-          }
-          exit(-1);
-        }
-        if (page->read_bytes > 0) {
-          if (file_read_at(page->file, frame, page->read_bytes, page->file_offset) != page->read_bytes) {
-            frame_free(frame);
-            kill(f);
-          }
-        }
-        memset(frame + page->read_bytes, 0, page->zero_bytes);
-        if (!install_page(page->vaddr, frame, page->writable)) {
-          frame_free(frame);
-          kill(f);
-        }
-        page->frame = f_entry;
-        return;
-      case PAGE_STACK:
-        memset(frame, 0, PGSIZE);
-        // Install the page in the process's page table.
-        if (!install_page(page->vaddr, frame, page->writable)) {
-          frame_free(frame);  // Free the frame if installation fails.
-          kill(f);            // Terminate the process due to a fatal error.
-        }
-        return;
+    if (!page_load(page)) {
+      return false;
     }
+    page_read_ahead(page);
+    return true;
   }
- // Check if it is a stack growth
- if (user && is_stack_growth(fault_addr, f->esp)) {
-   struct frame_entry *f_entry = frame_alloc(PAL_USER, fault_page_addr);
+ // Check if it is a stack growth. A fault in the kernel comes from a
+ // system call touching user memory, so judge it by the user's stack
+ // pointer at the time of the call.
+ void *esp = user ? f->esp : thread_current()->user_esp;
+ if (esp != NULL && is_stack_growth(fault_addr, esp)) {
+   struct frame_entry *f_entry = frame_alloc(PAL_USER | PAL_ZERO, fault_page_addr);
+   if (f_entry == NULL) {
+     return false;
+   }
 
-   struct page *page = malloc(sizeof(struct page));
+   struct page *page = kmem_cache_alloc(&spt_cache);
    if (page == NULL) {
-     printf("page allocation failed!\n");
-     thread_exit();
+     frame_free(f_entry->frame_addr);
+     return false;
    }
    page->vaddr = fault_page_addr;
    page->status = PAGE_STACK;
    page->writable = true;
    page->swapped = false;
    page->frame = f_entry;
+   page->sequential = false;
+   page->shared = NULL;
 
-   pagedir_set_page(thread_current()->pagedir, fault_page_addr, f_entry->frame_addr, page->writable);
+   if (!pagedir_set_page(thread_current()->pagedir, fault_page_addr, f_entry->frame_addr, page->writable)) {
+     frame_free(f_entry->frame_addr);
+     kmem_cache_free(&spt_cache, page);
+     return false;
+   }
+   lock_acquire(&spt_lock);
    hash_insert(&thread_current()->spt, &page->hash_elem);
-   return;
+   lock_release(&spt_lock);
+   return true;
  }
 
-
- // not a stack growth, can't handle - exit process
-  if (lock_held_by_current_thread(&filesystem_lock)) {
-    lock_release(&filesystem_lock);
-  }
-  exit(-1);
+ // not a stack growth, can't handle
+ return false;
 }
\ No newline at end of file
@@ -9,7 +9,7 @@
 //#include <stdio.h>
 
 static uint32_t *active_pd (void);
-static void invalidate_pagedir (uint32_t *);
+static void invalidate_page (uint32_t *, const void *);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
@@ -155,10 +155,45 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
       *pte &= ~PTE_P;
-      invalidate_pagedir (pd);
+      invalidate_page (pd, upage);
     }
 }
 
+/* Flushing more pages than this one by one costs more than
+   flushing the whole TLB by reloading CR3, and refilling it
+   afterward. */
+#define INVLPG_MAX 32
+
+/* Marks the PAGE_CNT user virtual pages starting at UPAGE "not
+   present" in page directory PD, like calling
+   pagedir_clear_page() on each, but once more than INVLPG_MAX
+   pages have been cleared, flushes the whole TLB once at the end
+   instead of a page at a time. */
+void
+pagedir_clear_pages (uint32_t *pd, void *upage, size_t page_cnt)
+{
+  bool active = active_pd () == pd;
+  size_t cleared = 0;
+  uint8_t *page;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (page_cnt <= (size_t) ((uint8_t *) PHYS_BASE - (uint8_t *) upage)
+                      / PGSIZE);
+
+  for (page = upage; page_cnt-- > 0; page += PGSIZE)
+    {
+      uint32_t *pte = lookup_page (pd, page, false);
+      if (pte != NULL && (*pte & PTE_P) != 0)
+        {
+          *pte &= ~PTE_P;
+          if (active && ++cleared <= INVLPG_MAX)
+            invalidate_page (pd, page);
+        }
+    }
+  if (cleared > INVLPG_MAX)
+    pagedir_activate (pd);
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
@@ -183,7 +218,7 @@ pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty)
       else 
         {
           *pte &= ~(uint32_t) PTE_D;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -212,7 +247,7 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
       else 
         {
           *pte &= ~(uint32_t) PTE_A; 
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -239,7 +274,7 @@ pagedir_set_writable (uint32_t *pd, const void *vpage, bool writable)
       else 
         {
           *pte &= ~(uint32_t) PTE_W;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -275,19 +310,23 @@ active_pd (void)
 
 /* Some page table changes can cause the CPU's translation
    lookaside buffer (TLB) to become out-of-sync with the page
-   table.  When this happens, we have to "invalidate" the TLB by
-   re-activating it.
+   table.  When this happens, we have to "invalidate" the TLB
+   entry for the page that changed.
 
-   This function invalidates the TLB if PD is the active page
-   directory.  (If PD is not active then its entries are not in
-   the TLB, so there is no need to invalidate anything.) */
+   This function invalidates the TLB entry for VPAGE if PD is the
+   active page directory.  (If PD is not active then its user
+   entries are not in the TLB, so there is no need to invalidate
+   anything.)  Kernel pages are mapped by page tables that every
+   page directory shares, so their entries are always
+   invalidated. */
 static void
-invalidate_pagedir (uint32_t *pd) 
+invalidate_page (uint32_t *pd, const void *vpage) 
 {
-  if (active_pd () == pd) 
+  if (active_pd () == pd || !is_user_vaddr (vpage))
     {
-      /* Re-activating PD clears the TLB.  See [IA32-v3a] 3.12
-         "Translation Lookaside Buffers (TLBs)". */
-      pagedir_activate (pd);
-    } 
+      /* INVLPG drops just the one entry, leaving the rest of the
+         TLB intact.  See [IA32-v3a] 3.12 "Translation Lookaside
+         Buffers (TLBs)" and [IA32-v2a] "INVLPG". */
+      asm volatile ("invlpg (%0)" : : "r" (vpage) : "memory");
+    }
 }
@@ -0,0 +1,158 @@
+#include "userprog/pipe.h"
+#include <stdint.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "userprog/syscall.h"
+#include "userprog/uaccess.h"
+
+/* Pipes.
+
+   A pipe buffers up to PIPE_PAGES pages of data in a ring of
+   kernel pages, each taken from the kernel pool the first time
+   the ring reaches it.  Data moves straight between these pages
+   and the user's buffers, so a byte crosses memory twice on its
+   way from writer to reader.
+
+   Each file descriptor for a pipe, in any process, holds one
+   reference to its read end or its write end.  Reads wait for
+   data while the pipe has writers and return 0 at the end of the
+   data once it has none.  Writes wait for room while the pipe has
+   readers, and fail once it has none. */
+
+// Pages in a pipe's buffer
+#define PIPE_PAGES 16
+#define PIPE_SIZE (PIPE_PAGES * PGSIZE)
+
+struct pipe {
+  struct lock lock;             // Protects everything in the pipe
+  struct condition readable;    // Signalled when data arrives or writers go
+  struct condition writable;    // Signalled when room appears or readers go
+  uint8_t *pages[PIPE_PAGES];   // Buffer pages, null until first used
+  uint32_t head;                // Bytes read, ever
+  uint32_t tail;                // Bytes written, ever
+  unsigned readers;             // References to the read end
+  unsigned writers;             // References to the write end
+};
+
+/* Returns a new pipe with one reference to each of its ends, or a null pointer
+   if memory runs out */
+struct pipe *pipe_create(void) {
+  struct pipe *pipe = calloc(1, sizeof *pipe);
+  if (pipe == NULL) {
+    return NULL;
+  }
+  lock_init(&pipe->lock);
+  cond_init(&pipe->readable);
+  cond_init(&pipe->writable);
+  pipe->readers = 1;
+  pipe->writers = 1;
+  return pipe;
+}
+
+// Adds a reference to PIPE's write end if WRITER is true, else its read end
+void pipe_dup(struct pipe *pipe, bool writer) {
+  lock_acquire(&pipe->lock);
+  if (writer) {
+    pipe->writers++;
+  } else {
+    pipe->readers++;
+  }
+  lock_release(&pipe->lock);
+}
+
+/* Drops a reference to PIPE's write end if WRITER is true, else its read end,
+   waking whoever waits on the other end. Frees PIPE once both ends are gone */
+void pipe_close(struct pipe *pipe, bool writer) {
+  lock_acquire(&pipe->lock);
+  if (writer) {
+    pipe->writers--;
+    cond_broadcast(&pipe->readable, &pipe->lock);
+  } else {
+    pipe->readers--;
+    cond_broadcast(&pipe->writable, &pipe->lock);
+  }
+  bool dead = pipe->readers == 0 && pipe->writers == 0;
+  lock_release(&pipe->lock);
+  if (dead) {
+    for (int i = 0; i < PIPE_PAGES; i++) {
+      if (pipe->pages[i] != NULL) {
+        palloc_free_page(pipe->pages[i]);
+      }
+    }
+    free(pipe);
+  }
+}
+
+/* Reads up to SIZE bytes from PIPE into the user's BUFFER, waiting until
+   there are some to read or no writers left. Returns the number of bytes
+   read, 0 at the end of the data. Ends the process if BUFFER is bad */
+int pipe_read(struct pipe *pipe, void *buffer, unsigned size) {
+  lock_acquire(&pipe->lock);
+  while (pipe->head == pipe->tail && pipe->writers > 0 && size > 0) {
+    cond_wait(&pipe->readable, &pipe->lock);
+  }
+  unsigned done = 0;
+  while (done < size && pipe->head != pipe->tail) {
+    uint32_t ofs = pipe->head % PIPE_SIZE;
+    unsigned chunk = PGSIZE - ofs % PGSIZE;
+    if (chunk > pipe->tail - pipe->head) {
+      chunk = pipe->tail - pipe->head;
+    }
+    if (chunk > size - done) {
+      chunk = size - done;
+    }
+    if (!copy_to_user(buffer + done, pipe->pages[ofs / PGSIZE] + ofs % PGSIZE,
+                      chunk)) {
+      lock_release(&pipe->lock);
+      exit(-1);
+    }
+    pipe->head += chunk;
+    done += chunk;
+  }
+  if (done > 0) {
+    cond_broadcast(&pipe->writable, &pipe->lock);
+  }
+  lock_release(&pipe->lock);
+  return done;
+}
+
+/* Writes SIZE bytes from the user's BUFFER to PIPE, waiting for room as
+   needed. Returns the number of bytes written, which falls short of SIZE only
+   if the readers go away or memory runs out, or -1 if there are no readers to
+   begin with. Ends the process if BUFFER is bad */
+int pipe_write(struct pipe *pipe, const void *buffer, unsigned size) {
+  lock_acquire(&pipe->lock);
+  unsigned done = 0;
+  while (done < size) {
+    while (pipe->tail - pipe->head == PIPE_SIZE && pipe->readers > 0) {
+      cond_wait(&pipe->writable, &pipe->lock);
+    }
+    if (pipe->readers == 0) {
+      break;
+    }
+    uint32_t ofs = pipe->tail % PIPE_SIZE;
+    uint8_t **page = &pipe->pages[ofs / PGSIZE];
+    if (*page == NULL && (*page = palloc_get_page(0)) == NULL) {
+      break;
+    }
+    unsigned chunk = PGSIZE - ofs % PGSIZE;
+    if (chunk > PIPE_SIZE - (pipe->tail - pipe->head)) {
+      chunk = PIPE_SIZE - (pipe->tail - pipe->head);
+    }
+    if (chunk > size - done) {
+      chunk = size - done;
+    }
+    if (!copy_from_user(*page + ofs % PGSIZE, buffer + done, chunk)) {
+      lock_release(&pipe->lock);
+      exit(-1);
+    }
+    pipe->tail += chunk;
+    done += chunk;
+    cond_broadcast(&pipe->readable, &pipe->lock);
+  }
+  bool broken = pipe->readers == 0 && done == 0 && size > 0;
+  lock_release(&pipe->lock);
+  return broken ? -1 : (int) done;
+}
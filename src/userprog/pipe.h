@@ -0,0 +1,16 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+
+/* pipe() is declared with the other system calls in
+   lib/user/syscall.h. */
+struct pipe;
+
+struct pipe *pipe_create(void);
+void pipe_dup(struct pipe *pipe, bool writer);
+void pipe_close(struct pipe *pipe, bool writer);
+int pipe_read(struct pipe *pipe, void *buffer, unsigned size);
+int pipe_write(struct pipe *pipe, const void *buffer, unsigned size);
+
+#endif /* userprog/pipe.h */
@@ -21,13 +21,29 @@
 #include "vm/frame.h"
 #include "vm/page.h"
 #include "vm/mmap.h"
+#include "userprog/ring.h"
+#include "userprog/pipe.h"
 
 #define MAX_STR_LENGTH 1024
 
 static thread_func start_process NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
+static bool inherit_fds(void);
 static unsigned fd_hash(const struct hash_elem *p_, void *aux UNUSED);
 static bool fd_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED);
+static void child_info_release(int tid UNUSED, void *child_info_);
+
+struct kmem_cache fd_cache;
+struct kmem_cache child_info_cache;
+
+/* Initializes the caches that per-process structures come from. */
+void
+process_init (void)
+{
+  kmem_cache_init (&fd_cache, "fd", sizeof (struct file_descriptor), NULL);
+  kmem_cache_init (&child_info_cache, "child_info",
+                   sizeof (struct child_info), NULL);
+}
 
 /* Starts a new thread running a user program loaded from
    FILENAME.  The new thread may be scheduled (and may even exit)
@@ -84,7 +100,7 @@ process_execute (const char *file_name)
   intr_set_level(old_level);
 
   // child_info allocation and init code
-  struct child_info *child_info = malloc(sizeof(struct child_info));
+  struct child_info *child_info = kmem_cache_alloc(&child_info_cache);
   if (child_info == NULL) {
     return TID_ERROR;
   }
@@ -99,15 +115,18 @@ process_execute (const char *file_name)
   child_info->load_success = true;
   child_info->waited = false;
   sema_init(&child_info->wait_sema, 0);
-  list_push_back(&cur->children_list, &child_info->elem);
+  if (!intmap_insert(&cur->children, tid, child_info)) {
+    kmem_cache_free(&child_info_cache, child_info);
+    return TID_ERROR;
+  }
   child->my_info = child_info;
 
   // Waiting for load to finish
   sema_down(&child_info->load_wait);
   if (!child_info->load_success) {
     // If failed, free just allocated child_info to not leak resources
-    list_remove(&child_info->elem);
-    free(child_info);
+    intmap_remove(&cur->children, tid);
+    kmem_cache_free(&child_info_cache, child_info);
     return TID_ERROR;
   }
 
@@ -125,7 +144,7 @@ start_process (void *file_name_)
   struct thread *cur = thread_current();
   hash_init(&cur->fd_hash_table, fd_hash, fd_less, NULL);
   hash_init(&cur->spt, spt_hash, spt_less, NULL);
-  hash_init(&cur->mmap_hash_table, mmap_hash, mmap_less, NULL);
+  intmap_init(&cur->mmap_table);
   
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
@@ -152,6 +171,9 @@ start_process (void *file_name_)
   success = load (argv[0], &if_.eip, &if_.esp);
   lock_release(&filesystem_lock);
 
+  // Handing down the parent's descriptors while it waits for the result
+  success = success && inherit_fds();
+
   // Sending load result to process_execute
   cur->my_info->load_success = success;
   sema_up(&cur->my_info->load_wait);
@@ -216,34 +238,91 @@ int
 process_wait (tid_t child_tid UNUSED) 
 {
   struct thread *cur = thread_current();
-  for (struct list_elem *e = list_begin(&cur->children_list); e != list_end(&cur->children_list); e = list_next(e)) {
-    struct child_info *child_info = list_entry(e, struct child_info, elem);
-    if (child_info->child_tid == child_tid && !child_info->waited) {
-      child_info->waited = true;
-
-      sema_down(&child_info->wait_sema);
-
-      list_remove(&child_info->elem);
-      int status = child_info->exit_status;
-      lock_acquire(&child_info->access_lock);
-      child_info->accesses++;
-      if (child_info->accesses == 2) {
-        lock_release(&child_info->access_lock);
-        free(child_info);
-      } else {
-        lock_release(&child_info->access_lock);
-      }
-      return status;
-    }
+  struct child_info *child_info = intmap_find(&cur->children, child_tid);
+  if (child_info == NULL || child_info->waited) {
+    return -1; // tid is invalid / not child of this process
+  }
+  child_info->waited = true;
+
+  sema_down(&child_info->wait_sema);
+
+  intmap_remove(&cur->children, child_tid);
+  int status = child_info->exit_status;
+  child_info_release(child_tid, child_info);
+  return status;
+}
+
+/* Drops one of the two references to a child_info held by the parent and the
+   child, freeing it once both have let go. Also used as the action for
+   destroying the children map. */
+static void child_info_release(int tid UNUSED, void *child_info_) {
+  struct child_info *child_info = child_info_;
+  lock_acquire(&child_info->access_lock);
+  child_info->accesses++;
+  if (child_info->accesses == 2) {
+    lock_release(&child_info->access_lock);
+    kmem_cache_free(&child_info_cache, child_info);
+  } else {
+    lock_release(&child_info->access_lock);
   }
-  return -1; // tid is invalid / not child of this process
 }
 
 /* Function for free'ing file_descriptor's in hash_destroy */
 static void fd_free(struct hash_elem *e, void *aux UNUSED) {
   struct file_descriptor *file_descriptor = hash_entry(e, struct file_descriptor, hash_elem);
-  file_close(file_descriptor->file);
-  free(file_descriptor);
+  if (file_descriptor->pipe != NULL) {
+    pipe_close(file_descriptor->pipe, file_descriptor->writer);
+  } else {
+    file_close(file_descriptor->file);
+  }
+  kmem_cache_free(&fd_cache, file_descriptor);
+}
+
+/* Gives the current process a copy of each of its parent's file descriptors,
+   under the same numbers, so that a child can be handed the end of a pipe.
+   Files are reopened at the parent's position, but each process moves its own
+   position from then on. The parent is waiting in process_execute() while
+   this runs. Returns false if memory runs out */
+static bool inherit_fds(void) {
+  struct thread *cur = thread_current();
+  enum intr_level old_level = intr_disable();
+  struct thread *parent = get_thread_by_tid(cur->my_info->parent_tid);
+  intr_set_level(old_level);
+  // The kernel's initial thread has no descriptors to hand down
+  if (parent == NULL || parent->pagedir == NULL) {
+    return true;
+  }
+
+  struct hash_iterator i;
+  hash_first(&i, &parent->fd_hash_table);
+  while (hash_next(&i)) {
+    struct file_descriptor *theirs = hash_entry(hash_cur(&i), struct file_descriptor, hash_elem);
+    struct file_descriptor *ours = kmem_cache_alloc(&fd_cache);
+    if (ours == NULL) {
+      return false;
+    }
+    ours->fd = theirs->fd;
+    ours->pipe = theirs->pipe;
+    ours->writer = theirs->writer;
+    ours->file = NULL;
+    if (theirs->pipe != NULL) {
+      pipe_dup(theirs->pipe, theirs->writer);
+    } else {
+      lock_acquire(&filesystem_lock);
+      ours->file = file_reopen(theirs->file);
+      if (ours->file != NULL) {
+        file_seek(ours->file, file_tell(theirs->file));
+      }
+      lock_release(&filesystem_lock);
+      if (ours->file == NULL) {
+        kmem_cache_free(&fd_cache, ours);
+        return false;
+      }
+    }
+    hash_insert(&cur->fd_hash_table, &ours->hash_elem);
+  }
+  cur->next_fd = parent->next_fd;
+  return true;
 }
 
 /* Function for getting hash for file_descriptor */
@@ -271,8 +350,11 @@ process_exit (void)
     lock_release(&filesystem_lock);
   }
 
+  // Let the I/O ring's worker finish before anything it uses goes away
+  ring_destroy();
+
   lock_acquire(&filesystem_lock);
-  hash_destroy(&cur->mmap_hash_table, mmap_free);
+  intmap_destroy(&cur->mmap_table, mmap_free);
   lock_release(&filesystem_lock);
   
   // Destroy hash and dealloc all resources used
@@ -284,30 +366,11 @@ process_exit (void)
   struct child_info *info = cur->my_info;
   if (info != NULL) {
     sema_up(&info->wait_sema);
-    lock_acquire(&info->access_lock);
-    info->accesses++;
-    if (info->accesses == 2) {
-      lock_release(&info->access_lock);
-      free(info);
-    } else {
-      lock_release(&info->access_lock);
-    }
+    child_info_release(cur->tid, info);
   }
 
   // Free unfreed child_info structs left
-  struct list_elem *e = list_begin(&cur->children_list);
-  while (e != list_end(&cur->children_list)) {
-    struct child_info *child_info = list_entry(e, struct child_info, elem);
-    e = list_remove(&child_info->elem);
-    lock_acquire(&child_info->access_lock);
-    child_info->accesses++;
-    if (child_info->accesses == 2) {
-      lock_release(&child_info->access_lock);
-      free(child_info);
-    } else {
-      lock_release(&child_info->access_lock);
-    }
-  }
+  intmap_destroy(&cur->children, child_info_release);
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -425,6 +488,7 @@ load (const char *file_name, void (**eip) (void), void **esp)
   struct Elf32_Ehdr ehdr;
   struct file *file = NULL;
   off_t file_ofs;
+  uintptr_t heap_start = 0;
   bool success = false;
   int i;
 
@@ -510,6 +574,8 @@ load (const char *file_name, void (**eip) (void), void **esp)
               if (!load_segment (file, file_page, (void *) mem_page,
                                  read_bytes, zero_bytes, writable))
                 goto done;
+              if (mem_page + read_bytes + zero_bytes > heap_start)
+                heap_start = mem_page + read_bytes + zero_bytes;
             }
           else
             goto done;
@@ -517,6 +583,9 @@ load (const char *file_name, void (**eip) (void), void **esp)
         }
     }
 
+  /* The heap starts empty, just above the highest segment. */
+  t->heap_start = t->brk = (void *) heap_start;
+
   /* Set up stack. */
   if (!setup_stack (esp))
     goto done;
@@ -604,6 +673,10 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (ofs % PGSIZE == 0);
 
   struct thread *cur = thread_current();
+  lock_acquire(&spt_lock);
+  hash_reserve(&cur->spt,
+               hash_size(&cur->spt) + (read_bytes + zero_bytes) / PGSIZE);
+  lock_release(&spt_lock);
   file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
@@ -613,7 +686,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-      struct page *page = malloc(sizeof(struct page));
+      struct page *page = kmem_cache_alloc(&spt_cache);
       if (page == NULL) {
         return false;
       }
@@ -626,8 +699,12 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       page->file_offset = ofs;
       page->frame = NULL;
       page->swapped = false;
+      page->sequential = false;
+      page->shared = NULL;
 
+      lock_acquire(&spt_lock);
       hash_insert(&cur->spt, &page->hash_elem);
+      lock_release(&spt_lock);
 
       // Simulate advancing by file_read
       ofs += page_read_bytes;
@@ -651,14 +728,18 @@ setup_stack (void **esp)
 
   struct frame_entry *f_entry = frame_alloc((PAL_USER | PAL_ZERO), upage);
   kpage = f_entry->frame_addr;
-  struct page *page = malloc(sizeof (struct page));
+  struct page *page = kmem_cache_alloc(&spt_cache);
   page->vaddr = f_entry->upage_addr;
   page->frame = f_entry;
   page->status = PAGE_STACK;
   page->swapped = false;
   page->writable = true;
+  page->sequential = false;
+  page->shared = NULL;
 
+  lock_acquire(&spt_lock);
   hash_insert(&thread_current()->spt, &page->hash_elem);
+  lock_release(&spt_lock);
 
   if (kpage != NULL) 
     {
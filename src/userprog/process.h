@@ -7,13 +7,16 @@
 #include "threads/synch.h"
 #include "userprog/pagedir.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "lib/kernel/hash.h"
 
 struct lock filesystem_lock;
 
 struct file_descriptor {
     int fd;
-    struct file *file;
+    struct file *file;          /* File, or null for a pipe end */
+    struct pipe *pipe;          /* Pipe it is an end of, or null */
+    bool writer;                /* Whether it is PIPE's write end */
     struct hash_elem hash_elem;
 };
 
@@ -28,9 +31,12 @@ struct child_info {
     bool load_success; /* Was load() successful flag */
     struct semaphore wait_sema; /* process_wait sema */
     struct semaphore load_wait;
-    struct list_elem elem; /* list elem for children_list */
 };
 
+extern struct kmem_cache fd_cache;         /* Cache of file_descriptor. */
+extern struct kmem_cache child_info_cache; /* Cache of child_info. */
+
+void process_init (void);
 tid_t process_execute (const char *file_name);
 int process_wait (tid_t);
 void process_exit (void);
@@ -0,0 +1,321 @@
+#include "userprog/ring.h"
+#include <list.h>
+#include <string.h>
+#include "user/ring.h"
+#include "filesys/directory.h"
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/exception.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+
+/* I/O rings (see lib/user/ring.h for the process's view).
+
+   A ring's pages come straight from the user pool and are
+   mapped into the process but kept out of the frame table, so
+   they are never evicted and the kernel can always reach them
+   through their kernel addresses, from any thread.
+
+   ring_enter() takes entries off the submission queue in the
+   process's own thread.  Opens and closes change the process's
+   file descriptor table, which only that thread touches, so they
+   are carried out there and then.  Reads and writes go on a list
+   for a worker thread that each ring has, together with a handle
+   of their own on the file, so that closing the descriptor does
+   not pull the file out from under the worker. */
+
+// A process's I/O ring
+struct ring {
+  void *uaddr;                  // User address of the ring
+  uint8_t *kaddr;               // Kernel address of the ring
+  size_t page_cnt;              // Pages in the ring, queues and buffers
+  uint32_t sq_head;             // Submission queue head, kept from the process
+  uint32_t cq_tail;             // Completion queue tail, kept from the process
+
+  struct lock lock;             // Protects what follows, and the completion queue
+  struct list work;             // Reads and writes waiting for the worker
+  struct condition work_ready;  // Signalled when work is queued or dying is set
+  struct condition completed;   // Signalled when an operation completes
+  unsigned inflight;            // Operations submitted and not yet completed
+  bool dying;                   // Tells the worker to exit once work is empty
+  struct semaphore worker_done; // Upped by the worker as it exits
+};
+
+// A read or write queued for a ring's worker
+struct ring_work {
+  struct list_elem elem;        // Element in the ring's work list
+  bool write;                   // Write if true, read if false
+  struct file *file;            // Handle of the worker's own, closed when done
+  uint8_t *kbuf;                // Kernel address of the buffer
+  uint32_t len;                 // Bytes to move
+  off_t offset;                 // Where in the file
+  uint32_t user_data;           // For the completion
+};
+
+// Cache that ring_work structs come from
+static struct kmem_cache work_cache;
+
+static void ring_worker(void *ring_);
+
+void ring_init(void) {
+  ASSERT(sizeof(struct ring_sq) <= RING_QUEUE_SIZE);
+  ASSERT(sizeof(struct ring_cq) <= RING_QUEUE_SIZE);
+  ASSERT(RING_QUEUE_SIZE == PGSIZE);
+  kmem_cache_init(&work_cache, "ring work", sizeof(struct ring_work), NULL);
+}
+
+/* Returns the kernel address of the LEN bytes at user address UBUF, or a null
+   pointer if they are not all within RING's buffers */
+static uint8_t *ring_buffer(struct ring *ring, const void *ubuf, uint32_t len) {
+  uintptr_t start = (uintptr_t) RING_BUF(ring->uaddr);
+  uintptr_t end = (uintptr_t) ring->uaddr + ring->page_cnt * PGSIZE;
+  uintptr_t addr = (uintptr_t) ubuf;
+  if (addr < start || addr > end || len > end - addr) {
+    return NULL;
+  }
+  return ring->kaddr + (addr - (uintptr_t) ring->uaddr);
+}
+
+/* Returns the number of completions that RING's process has yet to take.
+   The process might have set the head to anything, so this is at most
+   RING_ENTRIES. RING's lock must be held */
+static uint32_t cq_ready(struct ring *ring) {
+  uint32_t ready = ring->cq_tail - RING_CQ(ring->kaddr)->head;
+  return ready < RING_ENTRIES ? ready : RING_ENTRIES;
+}
+
+/* Posts a completion of RESULT for the operation with USER_DATA to RING.
+   ring_enter() only submits an operation when there is room for its
+   completion. RING's lock must be held */
+static void complete(struct ring *ring, uint32_t user_data, int32_t result) {
+  struct ring_cq *cq = RING_CQ(ring->kaddr);
+  struct ring_cqe *cqe = &cq->cqes[ring->cq_tail % RING_ENTRIES];
+  cqe->user_data = user_data;
+  cqe->result = result;
+  // Fill in the entry before the process can see it
+  barrier();
+  cq->tail = ++ring->cq_tail;
+  cond_broadcast(&ring->completed, &ring->lock);
+}
+
+/* Queues the read or write in SQE for RING's worker. Returns false, queueing
+   nothing, if the operation is bad */
+static bool queue_io(struct ring *ring, const struct ring_sqe *sqe) {
+  uint8_t *kbuf = ring_buffer(ring, sqe->buf, sqe->len);
+  struct file *file = get_file_by_fd(sqe->fd);
+  if (kbuf == NULL || file == NULL || (off_t) sqe->offset < 0) {
+    return false;
+  }
+  struct ring_work *work = kmem_cache_alloc(&work_cache);
+  if (work == NULL) {
+    return false;
+  }
+  lock_acquire(&filesystem_lock);
+  work->file = file_reopen(file);
+  lock_release(&filesystem_lock);
+  if (work->file == NULL) {
+    kmem_cache_free(&work_cache, work);
+    return false;
+  }
+  work->write = sqe->op == RING_WRITE;
+  work->kbuf = kbuf;
+  work->len = sqe->len;
+  work->offset = sqe->offset;
+  work->user_data = sqe->user_data;
+
+  lock_acquire(&ring->lock);
+  list_push_back(&ring->work, &work->elem);
+  ring->inflight++;
+  cond_signal(&ring->work_ready, &ring->lock);
+  lock_release(&ring->lock);
+  return true;
+}
+
+// Carries out the operation in SQE, or queues it for RING's worker
+static void submit(struct ring *ring, const struct ring_sqe *sqe) {
+  int32_t result = -1;
+  switch (sqe->op) {
+    case RING_NOP:
+      result = 0;
+      break;
+    case RING_READ:
+    case RING_WRITE:
+      if (queue_io(ring, sqe)) {
+        return;
+      }
+      break;
+    case RING_OPEN: {
+      uint8_t *kname = ring_buffer(ring, sqe->buf, sqe->len);
+      if (kname != NULL && sqe->len <= NAME_MAX) {
+        char name[NAME_MAX + 1];
+        memcpy(name, kname, sqe->len);
+        name[sqe->len] = '\0';
+        result = open(name);
+      }
+      break;
+    }
+    case RING_CLOSE:
+      close(sqe->fd);
+      result = 0;
+      break;
+  }
+  lock_acquire(&ring->lock);
+  complete(ring, sqe->user_data, result);
+  lock_release(&ring->lock);
+}
+
+// Carries out the reads and writes queued for RING until it dies
+static void ring_worker(void *ring_) {
+  struct ring *ring = ring_;
+  lock_acquire(&ring->lock);
+  for (;;) {
+    while (list_empty(&ring->work) && !ring->dying) {
+      cond_wait(&ring->work_ready, &ring->lock);
+    }
+    if (list_empty(&ring->work)) {
+      break;
+    }
+    struct ring_work *work = list_entry(list_pop_front(&ring->work),
+                                        struct ring_work, elem);
+    lock_release(&ring->lock);
+
+    lock_acquire(&filesystem_lock);
+    int result = work->write
+                 ? file_write_at(work->file, work->kbuf, work->len, work->offset)
+                 : file_read_at(work->file, work->kbuf, work->len, work->offset);
+    file_close(work->file);
+    lock_release(&filesystem_lock);
+
+    lock_acquire(&ring->lock);
+    ring->inflight--;
+    complete(ring, work->user_data, result);
+    kmem_cache_free(&work_cache, work);
+  }
+  lock_release(&ring->lock);
+  sema_up(&ring->worker_done);
+}
+
+/* Maps an I/O ring with BUF_PAGES buffer pages at user address ADDR, which
+   must be page aligned and free, and starts its worker. A process has at most
+   one ring. Returns true if successful */
+bool ring_setup(void *addr, unsigned buf_pages) {
+  struct thread *cur = thread_current();
+  size_t page_cnt = 2 + buf_pages;
+  if (cur->ring != NULL || buf_pages > RING_BUF_MAX
+      || addr == NULL || pg_ofs(addr) != 0) {
+    return false;
+  }
+  for (size_t i = 0; i < page_cnt; i++) {
+    void *upage = addr + i * PGSIZE;
+    if (upage >= STACK_LIMIT
+        || spt_lookup(upage, &cur->spt) != NULL
+        || pagedir_get_page(cur->pagedir, upage) != NULL) {
+      return false;
+    }
+  }
+
+  struct ring *ring = malloc(sizeof *ring);
+  if (ring == NULL) {
+    return false;
+  }
+  ring->kaddr = palloc_get_multiple(PAL_USER | PAL_ZERO, page_cnt);
+  if (ring->kaddr == NULL) {
+    free(ring);
+    return false;
+  }
+  for (size_t i = 0; i < page_cnt; i++) {
+    if (!pagedir_set_page(cur->pagedir, addr + i * PGSIZE,
+                          ring->kaddr + i * PGSIZE, true)) {
+      pagedir_clear_pages(cur->pagedir, addr, i);
+      palloc_free_multiple(ring->kaddr, page_cnt);
+      free(ring);
+      return false;
+    }
+  }
+  ring->uaddr = addr;
+  ring->page_cnt = page_cnt;
+  ring->sq_head = 0;
+  ring->cq_tail = 0;
+  lock_init(&ring->lock);
+  list_init(&ring->work);
+  cond_init(&ring->work_ready);
+  cond_init(&ring->completed);
+  ring->inflight = 0;
+  ring->dying = false;
+  sema_init(&ring->worker_done, 0);
+
+  if (thread_create("ring", PRI_DEFAULT, ring_worker, ring) == TID_ERROR) {
+    pagedir_clear_pages(cur->pagedir, addr, page_cnt);
+    palloc_free_multiple(ring->kaddr, page_cnt);
+    free(ring);
+    return false;
+  }
+  cur->ring = ring;
+  return true;
+}
+
+/* Submits up to TO_SUBMIT operations from the ring's submission queue, fewer
+   if the queue runs out or the completion queue has no room for more, then
+   waits until at least MIN_COMPLETE completions are ready or none are to come.
+   Returns the number of operations submitted, or -1 if there is no ring */
+int ring_enter(unsigned to_submit, unsigned min_complete) {
+  struct ring *ring = thread_current()->ring;
+  if (ring == NULL) {
+    return -1;
+  }
+
+  struct ring_sq *sq = RING_SQ(ring->kaddr);
+  unsigned submitted = 0;
+  while (submitted < to_submit && ring->sq_head != sq->tail) {
+    lock_acquire(&ring->lock);
+    bool room = ring->inflight + cq_ready(ring) < RING_ENTRIES;
+    lock_release(&ring->lock);
+    if (!room) {
+      break;
+    }
+    // Read the entry only after the tail, and copy it so that the process
+    // cannot change it while we use it
+    barrier();
+    struct ring_sqe sqe = sq->sqes[ring->sq_head % RING_ENTRIES];
+    sq->head = ++ring->sq_head;
+    submit(ring, &sqe);
+    submitted++;
+  }
+
+  if (min_complete > RING_ENTRIES) {
+    min_complete = RING_ENTRIES;
+  }
+  lock_acquire(&ring->lock);
+  while (cq_ready(ring) < min_complete && ring->inflight > 0) {
+    cond_wait(&ring->completed, &ring->lock);
+  }
+  lock_release(&ring->lock);
+  return submitted;
+}
+
+/* Stops the current process's ring's worker, once it has finished the work
+   already queued, and unmaps and frees the ring */
+void ring_destroy(void) {
+  struct thread *cur = thread_current();
+  struct ring *ring = cur->ring;
+  if (ring == NULL) {
+    return;
+  }
+  lock_acquire(&ring->lock);
+  ring->dying = true;
+  cond_signal(&ring->work_ready, &ring->lock);
+  lock_release(&ring->lock);
+  sema_down(&ring->worker_done);
+
+  pagedir_clear_pages(cur->pagedir, ring->uaddr, ring->page_cnt);
+  palloc_free_multiple(ring->kaddr, ring->page_cnt);
+  free(ring);
+  cur->ring = NULL;
+}
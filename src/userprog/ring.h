@@ -0,0 +1,9 @@
+#ifndef USERPROG_RING_H
+#define USERPROG_RING_H
+
+/* ring_setup() and ring_enter() are declared with the other
+   system calls in lib/user/syscall.h. */
+void ring_init(void);
+void ring_destroy(void);
+
+#endif /* userprog/ring.h */
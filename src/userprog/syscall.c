@@ -3,220 +3,507 @@
 #include <syscall-nr.h>
 #include <round.h>
 #include <inttypes.h>
+#include <limits.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "filesys/file.h"
 #include "../devices/shutdown.h"
 #include "../filesys/filesys.h"
 #include "threads/malloc.h"
 #include "devices/input.h"
+#include "devices/block.h"
 #include "pagedir.h"
 #include "threads/vaddr.h"
 #include "vm/page.h"
 #include "userprog/exception.h"
 #include "vm/mmap.h"
+#include "vm/share.h"
 #include "filesys/off_t.h"
-
-static void syscall_handler (struct intr_frame *);
-static bool valid_user_pointer(const void *uaddr);
-static bool valid_user_buffer(const void *buffer, unsigned size);
-typedef void (*syscall_func)(struct intr_frame *);
-
-syscall_func syscall_table[TOTAL_SYSCALL_NO];
+#include "filesys/directory.h"
+#include "threads/palloc.h"
+#include "userprog/uaccess.h"
+#include "userprog/ring.h"
+#include "userprog/pipe.h"
+#include "userprog/gdt.h"
+#include "userprog/tss.h"
+#include "threads/intr-stubs.h"
+#include "threads/msr.h"
+#include <sysenter.h>
+
+/* System calls come in through two interrupt vectors.
+
+   Through SYSCALL_STACK_VEC the system call number and its
+   arguments are on the user stack, in that order, as in the
+   original Pintos convention, which hand-written callers such as
+   the userprog tests still use.
+
+   Through SYSCALL_REG_VEC the number is in %eax and up to
+   SYSCALL_MAX_ARGS arguments are in %ebx, %ecx, %edx, %esi and
+   %edi, so that fetching them costs no user memory accesses.
+   The user library uses this convention, entering through
+   SYSENTER instead where the CPU has it (see syscall_sysenter
+   in threads/intr-stubs.S).
+
+   Either way the return value goes back in %eax. */
+#define SYSCALL_STACK_VEC 0x30
+#define SYSCALL_REG_VEC 0x31
+#define SYSCALL_MAX_ARGS 5
+
+// How the dispatcher passes each argument word on to a system call
+enum syscall_arg {
+  ARG_VAL,              // As is
+  ARG_NAME,             // As a file name copied into the kernel
+  ARG_STR               // As a string of up to a page copied into the kernel
+};
+
+// How the dispatcher reads a system call's return value
+enum syscall_ret {
+  RET_VOID,             // No return value
+  RET_INT,              // An int, or anything else that fills %eax
+  RET_BOOL              // A bool, which fills only %al
+};
+
+/* Every system call is called through this type, with all SYSCALL_MAX_ARGS
+   argument words. The cdecl calling convention makes the extra words
+   harmless to a function that takes fewer. The table casts functions to it
+   by way of a function type that takes no arguments, which GCC does not
+   warn about. */
+typedef int syscall_func(uint32_t, uint32_t, uint32_t, uint32_t, uint32_t);
+
+// A system call's entry in syscall_table
+struct syscall {
+  syscall_func *func;                       // Kernel function to call
+  enum syscall_ret ret;                     // Its return type
+  size_t argc;                              // Number of arguments it takes
+  enum syscall_arg args[SYSCALL_MAX_ARGS];  // How to pass each of them
+};
+
+#define SYSCALL(FUNC, RET, ARGC, ...) \
+  { (syscall_func *) (void (*)(void)) (FUNC), RET, ARGC, { __VA_ARGS__ } }
+
+// System calls, indexed by number
+static const struct syscall syscall_table[] = {
+  [SYS_HALT]     = SYSCALL(halt, RET_VOID, 0),
+  [SYS_EXIT]     = SYSCALL(exit, RET_VOID, 1, ARG_VAL),
+  [SYS_EXEC]     = SYSCALL(exec, RET_INT, 1, ARG_STR),
+  [SYS_WAIT]     = SYSCALL(wait, RET_INT, 1, ARG_VAL),
+  [SYS_CREATE]   = SYSCALL(create, RET_BOOL, 2, ARG_NAME, ARG_VAL),
+  [SYS_REMOVE]   = SYSCALL(remove, RET_BOOL, 1, ARG_NAME),
+  [SYS_OPEN]     = SYSCALL(open, RET_INT, 1, ARG_NAME),
+  [SYS_FILESIZE] = SYSCALL(filesize, RET_INT, 1, ARG_VAL),
+  [SYS_READ]     = SYSCALL(read, RET_INT, 3, ARG_VAL, ARG_VAL, ARG_VAL),
+  [SYS_WRITE]    = SYSCALL(write, RET_INT, 3, ARG_VAL, ARG_VAL, ARG_VAL),
+  [SYS_SEEK]     = SYSCALL(seek, RET_VOID, 2, ARG_VAL, ARG_VAL),
+  [SYS_TELL]     = SYSCALL(tell, RET_INT, 1, ARG_VAL),
+  [SYS_CLOSE]    = SYSCALL(close, RET_VOID, 1, ARG_VAL),
+  [SYS_MMAP]     = SYSCALL(mmap, RET_INT, 2, ARG_VAL, ARG_VAL),
+  [SYS_MUNMAP]   = SYSCALL(munmap, RET_VOID, 1, ARG_VAL),
+  [SYS_GETPID]   = SYSCALL(getpid, RET_INT, 0),
+  [SYS_PREAD]    = SYSCALL(pread, RET_INT, 4, ARG_VAL, ARG_VAL, ARG_VAL, ARG_VAL),
+  [SYS_PWRITE]   = SYSCALL(pwrite, RET_INT, 4, ARG_VAL, ARG_VAL, ARG_VAL, ARG_VAL),
+  [SYS_READV]    = SYSCALL(readv, RET_INT, 3, ARG_VAL, ARG_VAL, ARG_VAL),
+  [SYS_WRITEV]   = SYSCALL(writev, RET_INT, 3, ARG_VAL, ARG_VAL, ARG_VAL),
+  [SYS_RING_SETUP] = SYSCALL(ring_setup, RET_BOOL, 2, ARG_VAL, ARG_VAL),
+  [SYS_RING_ENTER] = SYSCALL(ring_enter, RET_INT, 2, ARG_VAL, ARG_VAL),
+  [SYS_COPY_FILE_RANGE] = SYSCALL(copy_file_range, RET_INT, 3, ARG_VAL, ARG_VAL, ARG_VAL),
+  [SYS_SBRK]     = SYSCALL(sbrk, RET_INT, 1, ARG_VAL),
+  [SYS_MMAP_RANGE] = SYSCALL(mmap_range, RET_INT, 5, ARG_VAL, ARG_VAL, ARG_VAL, ARG_VAL, ARG_VAL),
+  [SYS_MSYNC]    = SYSCALL(msync, RET_BOOL, 1, ARG_VAL),
+  [SYS_MADVISE]  = SYSCALL(madvise, RET_BOOL, 3, ARG_VAL, ARG_VAL, ARG_VAL),
+  [SYS_PIPE]     = SYSCALL(pipe, RET_INT, 1, ARG_VAL),
+};
+
+#define SYSCALL_CNT (sizeof syscall_table / sizeof *syscall_table)
+
+// Most bytes that copy_file_range() copies with filesystem_lock held
+#define COPY_CHUNK (64 * BLOCK_SECTOR_SIZE)
+
+static mapid_t map_file(void *addr, size_t length, int flags, int fd,
+                        off_t offset);
+
+// Cache that mmap_entry structs come from
+static struct kmem_cache mmap_cache;
 
 void
 syscall_init (void) 
 {
-  intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
-  syscall_table[SYS_HALT] = handle_halt;
-  syscall_table[SYS_EXIT] = handle_exit;
-  syscall_table[SYS_EXEC] = handle_exec;
-  syscall_table[SYS_WAIT] = handle_wait;
-  syscall_table[SYS_CREATE] = handle_create;
-  syscall_table[SYS_REMOVE] = handle_remove;
-  syscall_table[SYS_OPEN] = handle_open;
-  syscall_table[SYS_FILESIZE] = handle_filesize;
-  syscall_table[SYS_READ] = handle_read;
-  syscall_table[SYS_WRITE] = handle_write;
-  syscall_table[SYS_SEEK] = handle_seek;
-  syscall_table[SYS_TELL] = handle_tell;
-  syscall_table[SYS_CLOSE] = handle_close;
-  syscall_table[SYS_MMAP] = handle_mmap;
-  syscall_table[SYS_MUNMAP] = handle_munmap;
+  intr_register_int (SYSCALL_STACK_VEC, 3, INTR_ON, syscall_handler, "syscall");
+  intr_register_int (SYSCALL_REG_VEC, 3, INTR_ON, syscall_handler,
+                     "syscall (registers)");
+
+  // Also take system calls through SYSENTER, where the CPU has it
+  if (sysenter_supported()) {
+    wrmsr(MSR_SYSENTER_CS, SEL_KCSEG);
+    wrmsr(MSR_SYSENTER_EIP, (uintptr_t) syscall_sysenter);
+    tss_enable_sysenter();
+  }
 
   lock_init(&filesystem_lock);
+  kmem_cache_init(&mmap_cache, "mmap", sizeof(struct mmap_entry), NULL);
+  ring_init();
 }
 
-static void
-syscall_handler (struct intr_frame *f UNUSED) 
+/* Handles the system call whose frame is F, made through either interrupt
+   vector or through SYSENTER. Fetches the arguments that syscall_table says
+   the call takes, copies its string arguments into the kernel, and calls it,
+   ending the process if the number or any argument is bad */
+void
+syscall_handler (struct intr_frame *f) 
 {
-  if (!valid_user_pointer(f->esp)) {
+  // Kernel faults on the user stack are judged against this stack pointer
+  thread_current()->user_esp = f->esp;
+
+  uint32_t number;
+  if (f->vec_no == SYSCALL_STACK_VEC) {
+    if (!copy_from_user(&number, f->esp, sizeof number)) {
+      exit(-1);
+    }
+  } else {
+    number = f->eax;
+  }
+  if (number >= SYSCALL_CNT || syscall_table[number].func == NULL) {
     exit(-1);
   }
-  int syscall_number = *(int *)(f->esp);  // Get syscall number from stack pointer
-  if (syscall_number < 0 || syscall_number >= TOTAL_SYSCALL_NO || syscall_table[syscall_number] == NULL) {
-      exit(-1); // Invalid syscall number
-    } else {
-      syscall_table[syscall_number](f);  // Dispatch to the appropriate handler
+  const struct syscall *sc = &syscall_table[number];
+
+  uint32_t args[SYSCALL_MAX_ARGS] = {0};
+  if (f->vec_no == SYSCALL_STACK_VEC) {
+    if (!copy_from_user(args, (uint32_t *) f->esp + 1, sc->argc * sizeof *args)) {
+      exit(-1);
     }
-}
+  } else {
+    args[0] = f->ebx;
+    args[1] = f->ecx;
+    args[2] = f->edx;
+    args[3] = f->esi;
+    args[4] = f->edi;
+  }
+
+  /* A file name too long to fit is cut to NAME_MAX + 1 characters, which is
+     still too long to name a file, so the call fails as it should. A string
+     too long to fit in a page makes the call fail with -1 */
+  char name[NAME_MAX + 2];
+  char *page = NULL;
+  for (size_t i = 0; i < sc->argc; i++) {
+    if (sc->args[i] == ARG_NAME) {
+      if (strncpy_from_user(name, (const char *) args[i], sizeof name) < 0) {
+        exit(-1);
+      }
+      name[sizeof name - 1] = '\0';
+      args[i] = (uint32_t) name;
+    } else if (sc->args[i] == ARG_STR) {
+      page = palloc_get_page(0);
+      if (page == NULL) {
+        f->eax = -1;
+        return;
+      }
+      int len = strncpy_from_user(page, (const char *) args[i], PGSIZE);
+      if (len < 0) {
+        palloc_free_page(page);
+        exit(-1);
+      }
+      if (len == PGSIZE) {
+        palloc_free_page(page);
+        f->eax = -1;
+        return;
+      }
+      args[i] = (uint32_t) page;
+    }
+  }
+
+  trace(TRACE_SYSCALL_CALL, TRACE_BEGIN, number, 0);
+  int retval = sc->func(args[0], args[1], args[2], args[3], args[4]);
+  if (sc->ret == RET_INT) {
+    f->eax = retval;
+  } else if (sc->ret == RET_BOOL) {
+    f->eax = (uint8_t) retval;
+  }
+  trace(TRACE_SYSCALL_CALL, TRACE_END, number, f->eax);
 
-void handle_halt(struct intr_frame *f UNUSED) {
-  halt();
+  if (page != NULL) {
+    palloc_free_page(page);
+  }
 }
 
 void halt(void) {
   shutdown_power_off();
 }
 
-void handle_exit(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4)) {
-    exit(-1);
-  }
-  int status = *(int *)(f->esp + 4);  // Retrieve status from stack
-  exit(status);  // Call exit with status
-}
-
 void exit(int status) {
   printf("%s: exit(%d)\n", thread_current()->name, status);
   thread_current()->my_info->exit_status = status;
   thread_exit();
 }
 
-void handle_exec(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4)) {
-    exit(-1);
-  }
-  const char *cmd_line = *(const char **)(f->esp + 4);
-  if (!valid_user_pointer(cmd_line)) {
-    exit(-1);
-  }
-  f->eax = exec(cmd_line);
-}
-
 pid_t exec(const char *cmd_line) {
   return process_execute(cmd_line);
 }
 
-void handle_wait(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4)) {
-    exit(-1);
-  }
-  pid_t pid = *(pid_t *)(f->esp + 4);
-  f->eax = wait(pid);
-}
-
 int wait(pid_t pid) {
   return process_wait(pid);
 }
 
-void handle_write(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4) || !valid_user_pointer(f->esp + 8) || !valid_user_pointer(f->esp + 12)) {
-    exit(-1);
+pid_t getpid(void) {
+  return thread_current()->tid;
+}
+
+/* Moves up to SIZE bytes between the user's BUFFER and FILE, or the console if
+   FILE is null, a page at a time through the kernel page KBUF. Writes BUFFER
+   to FILE if WRITE is true, else reads FILE into BUFFER. Starts OFFSET bytes
+   into FILE without moving its position, or at its position if OFFSET is
+   negative. Only the file access holds filesystem_lock, so that a bad buffer
+   can end the process without leaving the lock held. Returns the number of
+   bytes moved, which falls short of SIZE only at the end of the file, or -1
+   if part of BUFFER is bad. */
+static int transfer(struct file *file, char *kbuf, void *buffer, unsigned size,
+                    off_t offset, bool write) {
+  unsigned done = 0;
+  while (done < size) {
+    unsigned chunk = size - done < PGSIZE ? size - done : PGSIZE;
+    unsigned moved;
+    if (write) {
+      if (!copy_from_user(kbuf, buffer + done, chunk)) {
+        return -1;
+      }
+      if (file == NULL) {
+        // Write to the console, which does not partial write
+        putbuf(kbuf, chunk);
+        moved = chunk;
+      } else {
+        lock_acquire(&filesystem_lock);
+        moved = offset < 0 ? file_write(file, kbuf, chunk)
+                           : file_write_at(file, kbuf, chunk, offset + done);
+        lock_release(&filesystem_lock);
+      }
+    } else {
+      if (file == NULL) {
+        // Read from keyboard
+        for (moved = 0; moved < chunk; moved++) {
+          kbuf[moved] = input_getc();
+        }
+      } else {
+        lock_acquire(&filesystem_lock);
+        moved = offset < 0 ? file_read(file, kbuf, chunk)
+                           : file_read_at(file, kbuf, chunk, offset + done);
+        lock_release(&filesystem_lock);
+      }
+      if (!copy_to_user(buffer + done, kbuf, moved)) {
+        return -1;
+      }
+    }
+    done += moved;
+    if (moved < chunk) {
+      break;
+    }
   }
-  int fd = *(int *)(f->esp + 4);                      // Retrieve fd from stack
-  const void *buffer = *(const void **)(f->esp + 8);  // Retrieve buffer pointer from stack
-  unsigned size = *(unsigned *)(f->esp + 12);         // Retrieve size from stack
-  if (fd > MAX_FILES_OPEN || !valid_user_buffer(buffer, size)) {
+  return done;
+}
+
+/* Looks up FD for a read, or a write if WRITE is true, and stores its file in
+   *FILE, or a null pointer if FD is the console and CONSOLE_OK is true.
+   Returns false if FD cannot be used that way. Ends the process if FD is far
+   out of range. */
+static bool io_file(int fd, bool write, bool console_ok, struct file **file) {
+  if (fd > MAX_FILES_OPEN) {
     exit(-1);
   }
-  lock_acquire(&filesystem_lock);
-  f->eax = write(fd, buffer, size);  // Call write and store the result in f->eax
-  lock_release(&filesystem_lock);
+  if (fd == (write ? STDOUT_FILENO : STDIN_FILENO)) {
+    *file = NULL;
+    return console_ok;
+  }
+  *file = get_file_by_fd(fd);
+  return *file != NULL;
 }
 
-int write(int fd, const void *buffer, unsigned size) {
-  if (buffer == NULL) {
-    return -1;  // Return -1 if buffer is NULL
+/* Returns the pipe that FD is the write end of, if WRITE is true, or the read
+   end of, if not, or a null pointer if FD is no such thing */
+static struct pipe *io_pipe(int fd, bool write) {
+  struct file_descriptor *file_descriptor = fd_lookup(fd);
+  if (file_descriptor == NULL || file_descriptor->pipe == NULL
+      || file_descriptor->writer != write) {
+    return NULL;
   }
-  if (fd == 1) {
-    // Write to the console
-    putbuf((const char *)buffer, size);  // Write the entire buffer to the console
-    return size;  // Return the full size since console output does not partial write
-  } else {
-    // Write to file
-    struct file *file = get_file_by_fd(fd);
-    if (file == NULL) {
+  return file_descriptor->pipe;
+}
+
+/* Carries out read(), write(), pread() or pwrite(), as described for
+   transfer(), or for pipe_read() and pipe_write() if FD is a pipe. */
+static int rw(int fd, void *buffer, unsigned size, off_t offset, bool write) {
+  struct pipe *pipe = io_pipe(fd, write);
+  if (pipe != NULL) {
+    // Pipes have no offsets
+    if (offset >= 0) {
       return -1;
     }
-    return file_write(file, buffer, size);
+    return write ? pipe_write(pipe, buffer, size)
+                 : pipe_read(pipe, buffer, size);
+  }
+  struct file *file;
+  if (!io_file(fd, write, offset < 0, &file)) {
+    return -1;
+  }
+  char *kbuf = palloc_get_page(0);
+  if (kbuf == NULL) {
+    return -1;
+  }
+  int done = transfer(file, kbuf, buffer, size, offset, write);
+  palloc_free_page(kbuf);
+  if (done < 0) {
+    exit(-1);
   }
+  return done;
 }
 
-void handle_open(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4)) {
-    exit(-1);
+/* Carries out readv() or writev(), moving data between FD and the IOVCNT
+   user buffers that UIOV describes, in order, until one comes up short. */
+static int rwv(int fd, const struct iovec *uiov, int iovcnt, bool write) {
+  struct iovec iov[IOV_MAX];
+  if (iovcnt < 0 || iovcnt > IOV_MAX) {
+    return -1;
   }
-  const char *filename = *(const char **)(f->esp + 4);
-  if (!valid_user_pointer(filename)) {
+  if (!copy_from_user(iov, uiov, iovcnt * sizeof *iov)) {
     exit(-1);
   }
-  lock_acquire(&filesystem_lock);
-  f->eax = open(filename);
-  lock_release(&filesystem_lock);
-}
+  // The total must fit in the return value
+  size_t total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    if (iov[i].iov_len > INT_MAX - total) {
+      return -1;
+    }
+    total += iov[i].iov_len;
+  }
 
-int open(const char *filename) {
-  struct file *file = filesys_open(filename);
-  if (file == NULL) {
-    return -1; // could not open file
+  struct pipe *pipe = io_pipe(fd, write);
+  if (pipe != NULL) {
+    int done = 0;
+    for (int i = 0; i < iovcnt; i++) {
+      int moved = write ? pipe_write(pipe, iov[i].iov_base, iov[i].iov_len)
+                        : pipe_read(pipe, iov[i].iov_base, iov[i].iov_len);
+      if (moved < 0) {
+        return done > 0 ? done : -1;
+      }
+      done += moved;
+      if ((size_t) moved < iov[i].iov_len) {
+        break;
+      }
+    }
+    return done;
   }
-  struct file_descriptor *file_descriptor = malloc(sizeof(struct file_descriptor));
-  if (file_descriptor == NULL) {
-    file_close(file);
+
+  struct file *file;
+  if (!io_file(fd, write, true, &file)) {
     return -1;
   }
-  struct thread *cur = thread_current();
-  file_descriptor->file = file;
-  file_descriptor->fd = cur->next_fd++;
-  hash_insert(&cur->fd_hash_table, &file_descriptor->hash_elem);
-  return file_descriptor->fd;
+  char *kbuf = palloc_get_page(0);
+  if (kbuf == NULL) {
+    return -1;
+  }
+  int done = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    int moved = transfer(file, kbuf, iov[i].iov_base, iov[i].iov_len, -1, write);
+    if (moved < 0) {
+      palloc_free_page(kbuf);
+      exit(-1);
+    }
+    done += moved;
+    if ((size_t) moved < iov[i].iov_len) {
+      break;
+    }
+  }
+  palloc_free_page(kbuf);
+  return done;
 }
 
-void handle_read(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4) || !valid_user_pointer(f->esp + 8) || !valid_user_pointer(f->esp + 12)) {
-    exit(-1);
+int write(int fd, const void *buffer, unsigned size) {
+  return rw(fd, (void *) buffer, size, -1, true);
+}
+
+int read(int fd, void *buffer, unsigned size) {
+  return rw(fd, buffer, size, -1, false);
+}
+
+// Reads like read(), but at OFFSET in the file, leaving its position alone
+int pread(int fd, void *buffer, unsigned size, unsigned offset) {
+  if ((off_t) offset < 0) {
+    return -1;
   }
-  int fd = *(int *)(f->esp + 4);                      // Retrieve fd from stack
-  void *buffer = *(void **)(f->esp + 8);  // Retrieve buffer pointer from stack
-  unsigned size = *(unsigned *)(f->esp + 12);         // Retrieve size from stack
-  if (fd > MAX_FILES_OPEN || !valid_user_buffer(buffer, size)) {
-    exit(-1);
+  return rw(fd, buffer, size, offset, false);
+}
+
+// Writes like write(), but at OFFSET in the file, leaving its position alone
+int pwrite(int fd, const void *buffer, unsigned size, unsigned offset) {
+  if ((off_t) offset < 0) {
+    return -1;
   }
-  lock_acquire(&filesystem_lock);
-  f->eax = read(fd, buffer, size);
-  lock_release(&filesystem_lock);
+  return rw(fd, (void *) buffer, size, offset, true);
 }
 
-int read(int fd, void *buffer, unsigned size) {
-  if (buffer == NULL) {
-    return -1;  // Return -1 if buffer is NULL
-  }
-  if (fd == 0) {
-    // Read from keyboard
-    char *charbuf = (char *)buffer;
-    for (unsigned i = 0; i < size; i++) {
-      charbuf[i] = input_getc();
-    }
-    return size;
-  } else {
-    // Read from file
-    struct file *file = get_file_by_fd(fd);
-    if (file == NULL) {
+int readv(int fd, const struct iovec *iov, int iovcnt) {
+  return rwv(fd, iov, iovcnt, false);
+}
+
+int writev(int fd, const struct iovec *iov, int iovcnt) {
+  return rwv(fd, iov, iovcnt, true);
+}
+
+/* Copies up to LENGTH bytes from FD_IN to FD_OUT, starting at each file's
+   position and advancing both, without the data leaving the kernel. The lock
+   is taken for a COPY_CHUNK at a time, so that a long copy does not keep other
+   processes out of the file system. Returns the number of bytes copied, which
+   falls short of LENGTH only at the end of either file, or -1 */
+int copy_file_range(int fd_in, int fd_out, unsigned length) {
+  struct file *in = get_file_by_fd(fd_in);
+  struct file *out = get_file_by_fd(fd_out);
+  if (in == NULL || out == NULL || (off_t) length < 0) {
+    return -1;
+  }
+  // Copying a file onto an overlapping part of itself is not supported
+  if (file_get_inode(in) == file_get_inode(out)) {
+    lock_acquire(&filesystem_lock);
+    int64_t in_pos = file_tell(in);
+    int64_t out_pos = file_tell(out);
+    lock_release(&filesystem_lock);
+    if (in_pos < out_pos + length && out_pos < in_pos + length) {
       return -1;
     }
-    return file_read(file, buffer, size);
   }
-}
 
-void handle_filesize(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4)) {
-    exit(-1);
+  unsigned done = 0;
+  while (done < length) {
+    off_t chunk = length - done < COPY_CHUNK ? length - done : COPY_CHUNK;
+    lock_acquire(&filesystem_lock);
+    off_t copied = file_copy(out, in, chunk);
+    lock_release(&filesystem_lock);
+    done += copied;
+    if (copied < chunk) {
+      break;
+    }
   }
-  int fd = *(int *)(f->esp + 4);
+  return done;
+}
+
+int open(const char *filename) {
   lock_acquire(&filesystem_lock);
-  f->eax = filesize(fd);
+  struct file *file = filesys_open(filename);
+  if (file == NULL) {
+    lock_release(&filesystem_lock);
+    return -1; // could not open file
+  }
+  struct file_descriptor *file_descriptor = kmem_cache_alloc(&fd_cache);
+  if (file_descriptor == NULL) {
+    file_close(file);
+    lock_release(&filesystem_lock);
+    return -1;
+  }
+  struct thread *cur = thread_current();
+  file_descriptor->file = file;
+  file_descriptor->pipe = NULL;
+  file_descriptor->writer = false;
+  file_descriptor->fd = cur->next_fd++;
+  hash_insert(&cur->fd_hash_table, &file_descriptor->hash_elem);
   lock_release(&filesystem_lock);
+  return file_descriptor->fd;
 }
 
 int filesize(int fd) {
@@ -224,83 +511,45 @@ int filesize(int fd) {
   if (file == NULL) {
     return -1;
   }
-  return file_length(file);
-}
-
-void handle_create(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4) || !valid_user_pointer(f->esp + 8)) {
-    exit(-1);
-  }
-  const char *filename = *(const char **)(f->esp + 4);
-  unsigned initial_size = *(unsigned *)(f->esp + 8);
-  if (!valid_user_pointer(filename)) {
-    exit(-1);
-  }
   lock_acquire(&filesystem_lock);
-  f->eax = create(filename, initial_size);
+  int length = file_length(file);
   lock_release(&filesystem_lock);
+  return length;
 }
 
 bool create(const char *filename, unsigned initial_size) {
-  return filesys_create(filename, initial_size);
-}
-
-void handle_remove(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4)) {
-    exit(-1);
-  }
-  const char *filename = *(const char **)(f->esp + 4);
-  if (!valid_user_pointer(filename)) {
-    exit(-1);
-  }
   lock_acquire(&filesystem_lock);
-  f->eax = remove(filename);
+  bool success = filesys_create(filename, initial_size);
   lock_release(&filesystem_lock);
+  return success;
 }
 
 bool remove(const char *filename) {
-  return filesys_remove(filename);
-}
-
-void handle_seek(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4) || !valid_user_pointer(f->esp + 8)) {
-    exit(-1);
-  }
-  int fd = *(int *)(f->esp + 4);
-  unsigned position = *(unsigned *)(f->esp + 8);
   lock_acquire(&filesystem_lock);
-  seek(fd, position);
+  bool success = filesys_remove(filename);
   lock_release(&filesystem_lock);
+  return success;
 }
 
 void seek(int fd, unsigned position) {
   struct file *file = get_file_by_fd(fd);
-  file_seek(file, position);
-}
-
-void handle_tell(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4)) {
-    exit(-1);
+  if (file == NULL) {
+    return;
   }
-  int fd = *(int *)(f->esp + 4);
   lock_acquire(&filesystem_lock);
-  f->eax = tell(fd);
+  file_seek(file, position);
   lock_release(&filesystem_lock);
 }
 
 unsigned tell(int fd) {
   struct file *file = get_file_by_fd(fd);
-  return file_tell(file);
-}
-
-void handle_close(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4)) {
-    exit(-1);
+  if (file == NULL) {
+    return -1;
   }
-  int fd = *(int *)(f->esp + 4);
   lock_acquire(&filesystem_lock);
-  close(fd);
+  unsigned position = file_tell(file);
   lock_release(&filesystem_lock);
+  return position;
 }
 
 void close(int fd) {
@@ -309,70 +558,117 @@ void close(int fd) {
   if (file_descriptor == NULL) {
     return;
   }
-  file_close(file_descriptor->file);
+  if (file_descriptor->pipe != NULL) {
+    pipe_close(file_descriptor->pipe, file_descriptor->writer);
+  } else {
+    lock_acquire(&filesystem_lock);
+    file_close(file_descriptor->file);
+    lock_release(&filesystem_lock);
+  }
   hash_delete(&cur->fd_hash_table, &file_descriptor->hash_elem);
-  free(file_descriptor);
+  kmem_cache_free(&fd_cache, file_descriptor);
 }
 
-void handle_mmap(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4) || !valid_user_pointer(f->esp + 8)) {
+/* Creates a pipe and stores file descriptors for its read and write ends in
+   FDS[0] and FDS[1]. Returns 0 if successful, -1 if memory runs out */
+int pipe(int fds[2]) {
+  struct thread *cur = thread_current();
+  struct pipe *pipe = pipe_create();
+  if (pipe == NULL) {
+    return -1;
+  }
+  struct file_descriptor *ends[2];
+  ends[0] = kmem_cache_alloc(&fd_cache);
+  ends[1] = kmem_cache_alloc(&fd_cache);
+  if (ends[0] == NULL || ends[1] == NULL) {
+    for (int i = 0; i < 2; i++) {
+      if (ends[i] != NULL) {
+        kmem_cache_free(&fd_cache, ends[i]);
+      }
+      pipe_close(pipe, i == 1);
+    }
+    return -1;
+  }
+  int kfds[2];
+  for (int i = 0; i < 2; i++) {
+    ends[i]->file = NULL;
+    ends[i]->pipe = pipe;
+    ends[i]->writer = i == 1;
+    ends[i]->fd = kfds[i] = cur->next_fd++;
+    hash_insert(&cur->fd_hash_table, &ends[i]->hash_elem);
+  }
+  // The descriptors are closed with the rest when the process exits
+  if (!copy_to_user(fds, kfds, sizeof kfds)) {
     exit(-1);
   }
+  return 0;
+}
 
-
-  int fd = *(int *)(f->esp + 4);
-  void *addr = *(void **)(f->esp + 8);
+// Maps a whole file into memory, shared
+mapid_t mmap(int fd, void *addr) {
   lock_acquire(&filesystem_lock);
-  f->eax = mmap(fd, addr);
+  struct file *file = get_file_by_fd(fd);
+  size_t length = file != NULL ? file_length(file) : 0;
+  mapid_t mapid = map_file(addr, length, MAP_SHARED, fd, 0);
   lock_release(&filesystem_lock);
+  return mapid;
 }
 
-// Maps a file into memory
-mapid_t mmap(int fd, void *addr) {
-
+/* Maps LENGTH bytes at ADDR, which must be page aligned and free: zeros if
+   FLAGS has MAP_ANON, or else the file open as FD from OFFSET, which must be
+   page aligned. A file mapping must not have pages past the end of the file.
+   Without MAP_SHARED, changes are private to the process */
+mapid_t mmap_range(void *addr, size_t length, int flags, int fd,
+                   unsigned offset) {
+  lock_acquire(&filesystem_lock);
+  mapid_t mapid = map_file(addr, length, flags, fd, offset);
+  lock_release(&filesystem_lock);
+  return mapid;
+}
 
+// Does the work of mmap_range(), with filesystem_lock held
+static mapid_t map_file(void *addr, size_t length, int flags, int fd,
+                        off_t offset) {
   struct thread *cur = thread_current();
-  ASSERT(cur != NULL);
-
-  struct file_descriptor *file_descriptor = fd_lookup(fd);
-
-
-  if (file_descriptor == NULL) {
-    return -1; // Failed to mmap, invalid fd
-  }
-
-  struct file *file = file_descriptor->file;
-
-  ASSERT(file != NULL); // A file_descriptor should have a valid file
-
-  if (file_length(file) == 0         // opened file should not be 0 bytes long
-      || addr != pg_round_down(addr) // addr must be page aligned
+  bool anon = (flags & MAP_ANON) != 0;
+  if (length == 0
       || addr == NULL                // addr can't be NULL
-      || fd == STDIN_FILENO          // Cannot map console input/output
-      || fd == STDOUT_FILENO) {
+      || addr != pg_round_down(addr) // addr must be page aligned
+      || addr >= STACK_LIMIT         // addr must be below the stack
+      || length > (uintptr_t) STACK_LIMIT - (uintptr_t) addr) {
     return -1; // Failed to mmap
   }
+  size_t num_pages = DIV_ROUND_UP(length, PGSIZE);
 
-  struct file *m_file = file_reopen(file);
-  if (m_file == NULL) {
-    return -1; // Failed to mmap, could not reopen the file
+  struct file *m_file = NULL;
+  off_t file_len = 0;
+  if (!anon) {
+    struct file *file = get_file_by_fd(fd);
+    if (file == NULL || offset < 0 || offset % PGSIZE != 0) {
+      return -1; // Failed to mmap, invalid fd or offset
+    }
+    file_len = file_length(file);
+    if (offset >= file_len
+        || num_pages > (size_t) DIV_ROUND_UP(file_len - offset, PGSIZE)) {
+      return -1; // Failed to mmap, past the end of the file
+    }
+    m_file = file_reopen(file);
+    if (m_file == NULL) {
+      return -1; // Failed to mmap, could not reopen the file
+    }
   }
 
-  int length = file_length(m_file);
-  int num_pages = DIV_ROUND_UP(length, PGSIZE);
   void *cur_addr = addr;
-
-  for (int i = 0; i < num_pages; i++) {
+  for (size_t i = 0; i < num_pages; i++) {
     if (spt_lookup(cur_addr, &cur->spt) != NULL  // Holds if memory already mapped
-        || cur_addr >= STACK_LIMIT) { /* Holds if we are in stack space or kernel
-                                         space */
+        || pagedir_get_page(cur->pagedir, cur_addr) != NULL) { // Or mapped outside the spt
       file_close(m_file);
       return -1; // Failed to mmap
     }
     cur_addr += PGSIZE; // Increment and check the next page for validity
   }
 
-  struct mmap_entry *mmap = malloc(sizeof(struct mmap_entry));
+  struct mmap_entry *mmap = kmem_cache_alloc(&mmap_cache);
   if (mmap == NULL) {
     file_close(m_file);
     return -1; // Failed to mmap, could not malloc
@@ -383,130 +679,195 @@ mapid_t mmap(int fd, void *addr) {
   mmap->file = m_file;
   mmap->start_addr = addr;
   mmap->length = length;
-  hash_insert(&cur->mmap_hash_table, &mmap->hash_elem);
+  if (!intmap_insert(&cur->mmap_table, mmap->mapid, mmap)) {
+    kmem_cache_free(&mmap_cache, mmap);
+    file_close(m_file);
+    return -1; // Failed to mmap, could not malloc
+  }
+
+  // Size the spt for the whole mapping up front rather than growing it
+  // page by page. A failure here only means the table grows as usual.
+  lock_acquire(&spt_lock);
+  hash_reserve(&cur->spt, hash_size(&cur->spt) + num_pages);
+  lock_release(&spt_lock);
 
-  cur_addr = addr;
-  off_t offset = 0;
   // Generating spt page entries for later lazy-loading
-  while (length > 0) {
-    size_t page_read_bytes = length < PGSIZE ? length : PGSIZE;
-    size_t page_zero_bytes = PGSIZE - page_read_bytes;
+  cur_addr = addr;
+  for (size_t i = 0; i < num_pages; i++) {
+    off_t page_offset = offset + i * PGSIZE;
+    size_t page_read_bytes = 0;
+    if (!anon) {
+      page_read_bytes = file_len - page_offset < PGSIZE
+                        ? (size_t) (file_len - page_offset) : PGSIZE;
+    }
 
-    struct page *page = malloc(sizeof(struct page));
+    struct page *page = kmem_cache_alloc(&spt_cache);
     if (page == NULL) {
-      munmap(mmap->mapid);
+      mmap->length = i * PGSIZE;
+      intmap_remove(&cur->mmap_table, mmap->mapid);
+      mmap_free(mmap->mapid, mmap);
       return -1; // Failed to mmap, could not malloc
     }
 
     page->vaddr = cur_addr;
-    page->status = PAGE_FILE;
+    page->status = anon ? PAGE_ANON : PAGE_FILE;
     page->file = m_file;
     page->writable = true;
     page->read_bytes = page_read_bytes;
-    page->zero_bytes = page_zero_bytes;
-    page->file_offset = offset;
+    page->zero_bytes = PGSIZE - page_read_bytes;
+    page->file_offset = page_offset;
     page->frame = NULL;
     page->swapped = false;
+    page->sequential = false;
+    page->shared = NULL;
+
+    if (!anon && (flags & MAP_SHARED) != 0
+        && !share_attach(page, file_get_inode(m_file), page_offset,
+                         page_read_bytes)) {
+      kmem_cache_free(&spt_cache, page);
+      mmap->length = i * PGSIZE;
+      intmap_remove(&cur->mmap_table, mmap->mapid);
+      mmap_free(mmap->mapid, mmap);
+      return -1; // Failed to mmap, could not malloc
+    }
 
     lock_acquire(&spt_lock);
-
     hash_insert(&cur->spt, &page->hash_elem);
-
     lock_release(&spt_lock);
 
-    length -= page_read_bytes;
     cur_addr += PGSIZE;
-    offset += page_read_bytes;
   }
 
   return mmap->mapid;
 }
 
-void handle_munmap(struct intr_frame *f) {
-  if (!valid_user_pointer(f->esp + 4)) {
-    exit(-1);
-  }
-  mapid_t mapping = *(mapid_t *)(f->esp + 4);
-  lock_acquire(&filesystem_lock);
-  munmap(mapping);
-  lock_release(&filesystem_lock);
-}
-
-// Helper function for unmapping pages in a map from memory
-static struct mmap_entry *unmap(struct hash_elem *h_e, struct thread *cur) {
-
-  struct mmap_entry *mmap = hash_entry(h_e, struct mmap_entry, hash_elem);
-  ASSERT(mmap != NULL);
-
-  void *cur_addr = mmap->start_addr;
-  size_t rem_length = mmap->length;
-
-  while (rem_length > 0) {
+/* Removes the pages of a mapping from memory. Shared file pages go back to the
+   file if this was their last mapping and they were changed; private pages
+   are dropped. The PTEs are cleared together at the end, so that a large
+   mapping costs one TLB flush rather than one per page */
+static void unmap(struct mmap_entry *mmap, struct thread *cur) {
+  uint8_t *end = (uint8_t *) mmap->start_addr + mmap->length;
+  for (uint8_t *cur_addr = mmap->start_addr; cur_addr < end;
+       cur_addr += PGSIZE) {
     struct page *page = spt_lookup(cur_addr, &cur->spt);
-    if (page != NULL) {
-      void *kernel_alias_addr = pagedir_get_page(cur->pagedir, cur_addr);
-      if (pagedir_is_dirty(cur->pagedir, cur_addr)) {
-        if (file_write_at(mmap->file, cur_addr, page->read_bytes, page->file_offset) != page->read_bytes) {
-          printf("Failed to write back to file during munmap\n");
-        }
-      }
-
-      pagedir_set_dirty(cur->pagedir, cur_addr, false);
-      pagedir_set_accessed(cur->pagedir, cur_addr, false);
-      pagedir_set_dirty(cur->pagedir, kernel_alias_addr, false);
-      pagedir_set_accessed(cur->pagedir, kernel_alias_addr, false);
-
-      pagedir_clear_page(cur->pagedir, cur_addr);
-
-      lock_acquire(&spt_lock);
-
-      hash_delete(&cur->spt, &page->hash_elem);
-
-      lock_release(&spt_lock);
-
-      free(page);
+    ASSERT(page != NULL);
+    if (page->status == PAGE_SHARED) {
+      share_detach(page, false);
+    } else {
+      page_release(page, false);
     }
 
-    size_t decrement = rem_length < PGSIZE ? rem_length : PGSIZE;
-    rem_length -= decrement;
-    cur_addr += PGSIZE;
+    lock_acquire(&spt_lock);
+    hash_delete(&cur->spt, &page->hash_elem);
+    lock_release(&spt_lock);
+    kmem_cache_free(&spt_cache, page);
   }
+  pagedir_clear_pages(cur->pagedir, mmap->start_addr,
+                      DIV_ROUND_UP(mmap->length, PGSIZE));
 
-  file_close(mmap->file);
-  return mmap;
+  if (mmap->file != NULL) {
+    file_close(mmap->file);
+  }
 }
 
 // Action function to unmap and free a map from memory
-void mmap_free(struct hash_elem *e, void *aux UNUSED) {
+void mmap_free(int mapid UNUSED, void *mmap_) {
 
-  struct thread *cur = thread_current();
+  struct mmap_entry *mmap = mmap_;
   // Unmapping the map
-  struct mmap_entry *mmap = unmap(e, cur);
+  unmap(mmap, thread_current());
   // Freeing the map
-  free(mmap);
+  kmem_cache_free(&mmap_cache, mmap);
 }
 
 /* Unmaps a mapping, deletes it from the memory mapping table, and frees it from
    memory */
 void munmap(mapid_t mapping) {
 
-  // Finding the mmap corresponding to mapping
-  struct mmap_entry temp_mmap;
-  temp_mmap.mapid = mapping;
+  // Finding the mmap corresponding to mapping and deleting it from the memory
+  // mapping table
   struct thread *cur = thread_current();
-
-  struct hash_elem *h_e = hash_find(&cur->mmap_hash_table, &temp_mmap.hash_elem);
-  ASSERT(h_e != NULL)
+  struct mmap_entry *mmap = intmap_remove(&cur->mmap_table, mapping);
+  if (mmap == NULL) {
+    return;
+  }
   // Unmapping
-  struct mmap_entry *mmap = unmap(h_e, cur);
-  // Deleting from memory mapping table
-  hash_delete(&cur->mmap_hash_table, &mmap->hash_elem);
+  lock_acquire(&filesystem_lock);
+  unmap(mmap, cur);
+  lock_release(&filesystem_lock);
   // Freeing the map
-  free(mmap);
+  kmem_cache_free(&mmap_cache, mmap);
 
   return;
 }
 
+/* Writes the changed pages of a shared file mapping back to the file. Returns
+   false if there is no such mapping */
+bool msync(mapid_t mapping) {
+  struct thread *cur = thread_current();
+  struct mmap_entry *mmap = intmap_find(&cur->mmap_table, mapping);
+  if (mmap == NULL) {
+    return false;
+  }
+  uint8_t *end = (uint8_t *) mmap->start_addr + mmap->length;
+  // Written back in the same lock order as munmap
+  lock_acquire(&filesystem_lock);
+  for (uint8_t *cur_addr = mmap->start_addr; cur_addr < end;
+       cur_addr += PGSIZE) {
+    struct page *page = spt_lookup(cur_addr, &cur->spt);
+    if (page->status == PAGE_SHARED) {
+      share_sync(page);
+    }
+  }
+  lock_release(&filesystem_lock);
+  return true;
+}
+
+/* Tells the kernel how the LENGTH bytes at ADDR, which must be page aligned
+   and all mapped, will be used:
+   - MADV_NORMAL: no special treatment.
+   - MADV_SEQUENTIAL: in order, so faults read ahead, and pages left behind
+     are evicted first.
+   - MADV_WILLNEED: soon, so read them in now.
+   - MADV_DONTNEED: not again soon, so free their memory. A private page
+     reads afresh from its file, or as zeros, next time; a shared page keeps
+     its contents.
+   Returns false, changing nothing, if the range or advice is bad */
+bool madvise(void *addr, size_t length, int advice) {
+  struct thread *cur = thread_current();
+  if (addr != pg_round_down(addr) || !is_user_vaddr(addr)
+      || length > (uintptr_t) PHYS_BASE - (uintptr_t) addr
+      || advice < MADV_NORMAL || advice > MADV_DONTNEED) {
+    return false;
+  }
+  uint8_t *end = (uint8_t *) addr + length;
+  for (uint8_t *upage = addr; upage < end; upage += PGSIZE) {
+    if (spt_lookup(upage, &cur->spt) == NULL) {
+      return false;
+    }
+  }
+
+  for (uint8_t *upage = addr; upage < end; upage += PGSIZE) {
+    struct page *page = spt_lookup(upage, &cur->spt);
+    switch (advice) {
+      case MADV_NORMAL:
+      case MADV_SEQUENTIAL:
+        page->sequential = advice == MADV_SEQUENTIAL;
+        break;
+      case MADV_WILLNEED:
+        if (pagedir_get_page(cur->pagedir, upage) == NULL
+            && !page_load(page)) {
+          return true; // Out of memory, so the rest can wait
+        }
+        break;
+      case MADV_DONTNEED:
+        page_release(page, true);
+        break;
+    }
+  }
+  return true;
+}
+
 // Helper function to lookup into fd_hash_table by fd
 struct file_descriptor* fd_lookup(int fd) {
   if (fd < 2) {
@@ -526,18 +887,3 @@ struct file* get_file_by_fd(int fd) {
   struct file_descriptor *file_descriptor = fd_lookup(fd);
   return file_descriptor != NULL ? file_descriptor->file : NULL;
 }
-
-// Helper function for pointer validation
-static bool valid_user_pointer(const void *uaddr) {
-  return uaddr != NULL && is_user_vaddr(uaddr);
-}
-
-// Helper function for user buffer validation
-static bool valid_user_buffer(const void *buffer, unsigned size) {
-  for (unsigned i = 0; i < size; i += PGSIZE) {
-    if (!valid_user_pointer(buffer + i)) {
-      return false;
-    }
-  }
-  return valid_user_pointer(buffer + size);
-}
@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <stddef.h>
 #include "userprog/gdt.h"
+#include "threads/msr.h"
 #include "threads/thread.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
@@ -75,6 +76,10 @@ struct tss
 /* Kernel TSS. */
 static struct tss *tss;
 
+/* True if SYSENTER's stack pointer follows the TSS's ring 0
+   stack pointer. */
+static bool sysenter_enabled;
+
 /* Initializes the kernel TSS. */
 void
 tss_init (void) 
@@ -97,10 +102,22 @@ tss_get (void)
 }
 
 /* Sets the ring 0 stack pointer in the TSS to point to the end
-   of the thread stack. */
+   of the thread stack, and SYSENTER's too if it is in use. */
 void
 tss_update (void) 
 {
   ASSERT (tss != NULL);
   tss->esp0 = (uint8_t *) thread_current () + PGSIZE;
+  if (sysenter_enabled)
+    wrmsr (MSR_SYSENTER_ESP, (uintptr_t) tss->esp0);
+}
+
+/* Makes SYSENTER, once the caller has set its code segment and
+   entry point, switch to the running thread's kernel stack, the
+   same as an interrupt from user mode would. */
+void
+tss_enable_sysenter (void) 
+{
+  sysenter_enabled = true;
+  tss_update ();
 }
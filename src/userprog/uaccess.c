@@ -0,0 +1,142 @@
+#include "userprog/uaccess.h"
+#include <stdint.h>
+#include "threads/vaddr.h"
+
+/* Access to user memory from the kernel.
+
+   These routines copy between kernel buffers and user addresses
+   without checking first that the user pages are mapped.  A
+   page fault in one of them goes to the page fault handler as
+   usual, which brings the page in if it can.  If it cannot, it
+   finds the faulting instruction in the exception table, a list
+   of (instruction, fixup) address pairs that the asm statements
+   below add to the __ex_table section, and resumes at the fixup
+   instead.  The fixup code makes the routine return failure.
+
+   So a good buffer costs a single range check and a block copy,
+   and a bad one costs a page fault, instead of every access
+   paying for a walk of the page tables first. */
+
+/* An exception table entry. */
+struct exception_entry
+  {
+    uintptr_t insn;             /* Instruction that may fault. */
+    uintptr_t fixup;            /* Where to resume if it does. */
+  };
+
+/* Bounds of the exception table, from the linker script. */
+extern const struct exception_entry _start_ex_table[], _end_ex_table[];
+
+/* Emits an exception table entry that sends unresolved faults at
+   the instruction labeled INSN to the label FIXUP. */
+#define EX_ENTRY(INSN, FIXUP)                   \
+  ".pushsection __ex_table, \"a\"\n"            \
+  ".balign 4\n"                                 \
+  ".long " #INSN ", " #FIXUP "\n"               \
+  ".popsection\n"
+
+/* Returns true if the SIZE bytes starting at user address UADDR
+   are all below PHYS_BASE. */
+static inline bool
+user_range_ok (const void *uaddr, size_t size)
+{
+  uintptr_t start = (uintptr_t) uaddr;
+  return start + size >= start && start + size <= (uintptr_t) PHYS_BASE;
+}
+
+/* Copies SIZE bytes from SRC to DST, a word at a time and then
+   byte by byte, stopping at the first unresolved page fault.
+   Returns the number of bytes left uncopied. */
+static size_t
+raw_copy (void *dst, const void *src, size_t size)
+{
+  size_t left = size / 4;
+
+  asm volatile ("1: rep movsl\n"
+                "   movl %3, %0\n"
+                "2: rep movsb\n"
+                "   jmp 4f\n"
+                "3: leal (%3,%0,4), %0\n"
+                "4:\n"
+                EX_ENTRY (1b, 3b)
+                EX_ENTRY (2b, 4b)
+                : "+c" (left), "+D" (dst), "+S" (src)
+                : "r" (size % 4)
+                : "memory");
+  return left;
+}
+
+/* Copies SIZE bytes from user address USRC to DST.  Returns true
+   if successful, false if part of the user buffer is not mapped
+   or is not in user memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  return user_range_ok (usrc, size) && raw_copy (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from SRC to user address UDST.  Returns true
+   if successful, false if part of the user buffer is not mapped,
+   is read-only, or is not in user memory. */
+bool
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  return user_range_ok (udst, size) && raw_copy (udst, src, size) == 0;
+}
+
+/* Copies the null-terminated string at user address USRC into
+   DST, which has room for SIZE bytes including the null.
+   Returns the length of the string.  If the string does not fit,
+   returns SIZE, leaving DST unterminated.  Returns -1 if part of
+   the string is not mapped or is not in user memory. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size)
+{
+  size_t max, left;
+  int error = 0;
+
+  if (!is_user_vaddr (usrc))
+    return -1;
+  max = (uintptr_t) PHYS_BASE - (uintptr_t) usrc;
+  if (max > size)
+    max = size;
+  if (max == 0)
+    return 0;
+
+  left = max;
+  asm volatile ("1: movb (%2), %%al\n"
+                "   movb %%al, (%1)\n"
+                "   incl %1\n"
+                "   incl %2\n"
+                "   testb %%al, %%al\n"
+                "   jz 3f\n"
+                "   decl %0\n"
+                "   jnz 1b\n"
+                "   jmp 3f\n"
+                "2: movl $-1, %3\n"
+                "3:\n"
+                EX_ENTRY (1b, 2b)
+                : "+r" (left), "+r" (dst), "+r" (usrc), "+r" (error)
+                : : "eax", "memory");
+  if (error)
+    return -1;
+
+  /* A string that runs into kernel memory is not in user memory. */
+  if (left == 0 && max < size)
+    return -1;
+  return max - left;
+}
+
+/* Returns the address at which to resume after an unresolved
+   page fault at EIP, or a null pointer if EIP is not in one of
+   the routines above. */
+void *
+uaccess_fixup (const void *eip)
+{
+  const struct exception_entry *e;
+
+  for (e = _start_ex_table; e < _end_ex_table; e++)
+    if (e->insn == (uintptr_t) eip)
+      return (void *) e->fixup;
+  return NULL;
+}
@@ -1,14 +1,28 @@
 #include <debug.h>
 #include <stdio.h>
+#include <string.h>
 #include "frame.h"
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "threads/malloc.h"
 #include "userprog/pagedir.h"
 #include "devices/swap.h"
 #include "page.h"
 #include "filesys/file.h"
+#include "share.h"
+
+// Cache the frame table entries come from
+static struct kmem_cache frame_entry_cache;
+
+// Initialises the frame table
+void frame_init(void) {
+  lock_init(&frame_table_lock);
+  hash_init(&frame_hash_table, frame_hash, frame_less, NULL);
+  kmem_cache_init(&frame_entry_cache, "frame", sizeof(struct frame_entry),
+                  NULL);
+}
 
 // Frame table hash function
 unsigned frame_hash(const struct hash_elem *p_hash_elem, void *aux UNUSED) {
@@ -28,6 +42,7 @@ bool frame_less(const struct hash_elem *a_, const struct hash_elem *b_,
 // Should be called with frame_table_lock acquired
 struct frame_entry *frame_evict(void *upage) {
   struct hash_iterator i;
+  trace(TRACE_EVICT, TRACE_BEGIN, (uintptr_t) upage, 0);
   hash_first(&i, &frame_hash_table);
   while (true) {
     if (!hash_next(&i)) {
@@ -36,17 +51,42 @@ struct frame_entry *frame_evict(void *upage) {
     }
     struct frame_entry *frame = hash_entry(hash_cur(&i), struct frame_entry, hash_elem);
     void *faddr = frame->upage_addr;
+
+    // A shared file page is written back to its file rather than to swap,
+    // and only once none of the processes mapping it has used it lately
+    if (frame->shared != NULL) {
+      if (!share_accessed(frame->shared)) {
+        share_evict(frame->shared);
+        frame->owner = thread_current();
+        frame->upage_addr = upage;
+        trace(TRACE_EVICT, TRACE_END, (uintptr_t) faddr,
+              (uintptr_t) frame->frame_addr);
+        return frame;
+      }
+      continue;
+    }
+
+    // A frame that is not mapped yet is still being filled in by the fault
+    // that allocated it
+    if (pagedir_get_page(frame->owner->pagedir, faddr) == NULL) {
+      continue;
+    }
     struct page *page = spt_lookup(faddr, &frame->owner->spt);
 
     if (!pagedir_is_accessed(frame->owner->pagedir, faddr)) {
-      page->swap_slot = swap_out(faddr);
+      // Unmap the victim from its owner before writing it out, so that
+      // the owner cannot change it meanwhile. This flushes just that one
+      // TLB entry, and only if the owner is the running process.
+      pagedir_clear_page(frame->owner->pagedir, faddr);
+      page->swap_slot = swap_out(frame->frame_addr);
       page->swapped = true;
       page->frame = NULL;
 
       frame->owner = thread_current();
-      pagedir_clear_page(frame->owner->pagedir, frame->upage_addr);
       frame->upage_addr = upage;
 
+      trace(TRACE_EVICT, TRACE_END, (uintptr_t) faddr,
+            (uintptr_t) frame->frame_addr);
 
       return frame;
     } else {
@@ -69,10 +109,14 @@ struct frame_entry *frame_alloc(enum palloc_flags flags, void *upage) {
     if (evicted == NULL) {
       PANIC("No frame to evict!");
     }
+    // An evicted frame still holds its previous owner's data
+    if (flags & PAL_ZERO) {
+      memset(evicted->frame_addr, 0, PGSIZE);
+    }
     lock_release(&frame_table_lock);
     return evicted;
   }
-  struct frame_entry *f_entry = malloc(sizeof *f_entry);
+  struct frame_entry *f_entry = kmem_cache_alloc(&frame_entry_cache);
   if (f_entry == NULL) { // Unable to allocate memory for frame table entry
       palloc_free_page(frame);
       return NULL;
@@ -80,14 +124,16 @@ struct frame_entry *frame_alloc(enum palloc_flags flags, void *upage) {
   f_entry->frame_addr = frame; 
   f_entry->upage_addr = upage;
   f_entry->owner = thread_current();
+  f_entry->shared = NULL;
   hash_insert(&frame_hash_table, &f_entry->hash_elem);
   lock_release(&frame_table_lock);
   return f_entry;
 }
 
-// palloc_free_page() wrapper function to remove frame table entry
-void frame_free(void *frame) {
-  lock_acquire(&frame_table_lock);
+// Removes FRAME's frame table entry and frees the page, with frame_table_lock
+// held
+void frame_free_locked(void *frame) {
+  ASSERT(lock_held_by_current_thread(&frame_table_lock));
   struct frame_entry temp_f_entry;
   temp_f_entry.frame_addr = frame;
 
@@ -97,8 +143,25 @@ void frame_free(void *frame) {
   if (h_e != NULL) {
     struct frame_entry *f_entry = hash_entry(h_e, struct frame_entry, hash_elem);
     hash_delete(&frame_hash_table, h_e);
-    free(f_entry);
+    kmem_cache_free(&frame_entry_cache, f_entry);
   }
-  lock_release(&frame_table_lock);
   palloc_free_page(frame);
-}
\ No newline at end of file
+}
+
+// palloc_free_page() wrapper function to remove frame table entry
+void frame_free(void *frame) {
+  lock_acquire(&frame_table_lock);
+  frame_free_locked(frame);
+  lock_release(&frame_table_lock);
+}
+
+// Marks the frame that UPAGE is mapped to in PD, if any, as one to evict
+// early: clears its accessed bit, so that the clock does not give it a second
+// chance
+void frame_deactivate(uint32_t *pd, void *upage) {
+  lock_acquire(&frame_table_lock);
+  if (pagedir_get_page(pd, upage) != NULL) {
+    pagedir_set_accessed(pd, upage, false);
+  }
+  lock_release(&frame_table_lock);
+}
@@ -2,9 +2,12 @@
 #define VM_FRAME_H
 
 #include <hash.h>
+#include <stdint.h>
 #include "threads/synch.h"
 #include "threads/palloc.h"
+#include "threads/slab.h"
 
+struct shared_page;
 
 struct hash frame_hash_table;
 struct lock frame_table_lock;
@@ -14,14 +17,18 @@ struct frame_entry {
                        mapping to RAM.*/ 
   void *upage_addr; // user virtual page the frame maps to
   struct thread *owner; // Thread that owns the frame
+  struct shared_page *shared; // Shared file page it holds, or null
   struct hash_elem hash_elem; // hash_elem for this frame table hash entry
 };
 
+void frame_init(void);
 unsigned frame_hash(const struct hash_elem *p_hash_elem, void *aux UNUSED);
 bool frame_less(const struct hash_elem *a_, const struct hash_elem *b_,
                 void *aux UNUSED);
 struct frame_entry *frame_evict(void *upage);
 struct frame_entry *frame_alloc(enum palloc_flags flags, void *upage);
 void frame_free(void *frame);
+void frame_free_locked(void *frame);
+void frame_deactivate(uint32_t *pd, void *upage);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include <stdint.h>
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/exception.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+
+/* A process's heap runs from heap_start, just above its highest
+   segment, up to its break.  The pages it covers are PAGE_ANON
+   entries in the SPT, which get zeroed frames only when first
+   touched, so growing the heap costs no memory until it is used. */
+
+// Removes the heap pages from START up to END from the current process and
+// frees their memory
+static void heap_shrink(uint8_t *start, uint8_t *end) {
+  struct thread *cur = thread_current();
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    struct page *page = spt_lookup(upage, &cur->spt);
+    ASSERT(page != NULL && page->status == PAGE_ANON);
+    page_release(page, true);
+    lock_acquire(&spt_lock);
+    hash_delete(&cur->spt, &page->hash_elem);
+    lock_release(&spt_lock);
+    kmem_cache_free(&spt_cache, page);
+  }
+}
+
+// Adds heap pages from START up to END to the current process, which must all
+// be free. Returns true if successful, false, adding nothing, if not
+static bool heap_grow(uint8_t *start, uint8_t *end) {
+  struct thread *cur = thread_current();
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    if (spt_lookup(upage, &cur->spt) != NULL
+        || pagedir_get_page(cur->pagedir, upage) != NULL) {
+      return false;
+    }
+  }
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    struct page *page = kmem_cache_alloc(&spt_cache);
+    if (page == NULL) {
+      heap_shrink(start, upage);
+      return false;
+    }
+    page->vaddr = upage;
+    page->status = PAGE_ANON;
+    page->writable = true;
+    page->frame = NULL;
+    page->swapped = false;
+    page->sequential = false;
+    page->shared = NULL;
+    lock_acquire(&spt_lock);
+    hash_insert(&cur->spt, &page->hash_elem);
+    lock_release(&spt_lock);
+  }
+  return true;
+}
+
+/* Moves the current process's break by INCREMENT bytes, which may be negative
+   or zero, and returns the old break. Returns (void *) -1, leaving the break
+   alone, if it would go below the start of the heap, or if the heap cannot
+   grow that far: past STACK_LIMIT or into pages already in use */
+void *sbrk(intptr_t increment) {
+  struct thread *cur = thread_current();
+  uintptr_t old_brk = (uintptr_t) cur->brk;
+  uintptr_t new_brk = old_brk + increment;
+  if (increment < 0
+      ? new_brk > old_brk || new_brk < (uintptr_t) cur->heap_start
+      : new_brk < old_brk || new_brk > (uintptr_t) STACK_LIMIT) {
+    return (void *) -1;
+  }
+
+  uint8_t *old_end = pg_round_up((void *) old_brk);
+  uint8_t *new_end = pg_round_up((void *) new_brk);
+  if (new_end > old_end) {
+    if (!heap_grow(old_end, new_end)) {
+      return (void *) -1;
+    }
+  } else {
+    heap_shrink(new_end, old_end);
+  }
+  cur->brk = (void *) new_brk;
+  return (void *) old_brk;
+}
@@ -2,6 +2,20 @@
 #include <stdio.h>
 #include "threads/malloc.h"
 #include "devices/serial.h"
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "vm/share.h"
+
+struct kmem_cache spt_cache;
+
+// Initialises the SPT lock and the cache SPT entries come from
+void spt_init(void) {
+  lock_init(&spt_lock);
+  kmem_cache_init(&spt_cache, "spt", sizeof(struct page), NULL);
+}
 
 // SPT hash function
 unsigned spt_hash(const struct hash_elem *p_hash_elem, void *aux UNUSED) {
@@ -19,7 +33,7 @@ bool spt_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux
 // SPT free function for hash_destroy
 void spt_free(struct hash_elem *e, void *aux UNUSED) {
   struct page* page = hash_entry(e, struct page, hash_elem);
-  free(page);
+  kmem_cache_free(&spt_cache, page);
 }
 
 // SPT lookup by vaddr function
@@ -30,4 +44,102 @@ struct page *spt_lookup(void *vaddr, struct hash *spt) {
   struct hash_elem *e = hash_find(spt, &page.hash_elem);
   lock_release(&spt_lock);
   return e != NULL ? hash_entry(e, struct page, hash_elem) : NULL;
-}
\ No newline at end of file
+}
+// Frees the memory behind PAGE, a page of the running process: its frame,
+// which is unmapped first, or else its swap slot. Holds frame_table_lock
+// throughout so that the page cannot be evicted meanwhile. Leaves PAGE itself
+// in the SPT. A shared page is only unmapped, since other processes may still
+// use its frame. If CLEAR_PTE is false, an unshared page's PTE is left for the
+// caller to clear, with one pagedir_clear_pages() over a whole range, before
+// the process runs again
+void page_release(struct page *page, bool clear_pte) {
+  if (page->status == PAGE_SHARED) {
+    share_release(page);
+    return;
+  }
+  uint32_t *pd = thread_current()->pagedir;
+  lock_acquire(&frame_table_lock);
+  void *kpage = pagedir_get_page(pd, page->vaddr);
+  if (kpage != NULL) {
+    if (clear_pte) {
+      pagedir_clear_page(pd, page->vaddr);
+    }
+    frame_free_locked(kpage);
+  } else if (page->swapped) {
+    swap_drop(page->swap_slot);
+  }
+  page->frame = NULL;
+  page->swapped = false;
+  lock_release(&frame_table_lock);
+}
+
+// Brings PAGE, a page of the running process that is not mapped, into a frame
+// and maps it. Returns false if that fails
+bool page_load(struct page *page) {
+  if (page->status == PAGE_SHARED) {
+    return share_load(page);
+  }
+  // Fresh stack and heap pages must read as zeros, so ask for a zeroed frame
+  enum palloc_flags flags = PAL_USER;
+  if ((page->status == PAGE_STACK || page->status == PAGE_ANON)
+      && !page->swapped) {
+    flags |= PAL_ZERO;
+  }
+  struct frame_entry *f_entry = frame_alloc(flags, page->vaddr);
+  if (f_entry == NULL) {
+    return false;
+  }
+  void *frame = f_entry->frame_addr;
+  if (page->swapped) {
+    // Read the page data from the swap partition
+    swap_in(frame, page->swap_slot);
+    page->swap_slot = -1;
+    page->swapped = false;
+  } else if (page->status == PAGE_FILE) {
+    if (page->read_bytes > 0
+        && file_read_at(page->file, frame, page->read_bytes,
+                        page->file_offset) != page->read_bytes) {
+      frame_free(frame);
+      return false;
+    }
+    memset(frame + page->read_bytes, 0, page->zero_bytes);
+  }
+  // Install the page in the process's page table
+  if (!install_page(page->vaddr, frame, page->writable)) {
+    frame_free(frame);
+    return false;
+  }
+  page->frame = f_entry;
+  return true;
+}
+
+// Pages that a fault in a MADV_SEQUENTIAL page reads in ahead of it, and how
+// far behind it pages are marked for early eviction
+#define READ_AHEAD_PAGES 8
+
+// Follows a fault that brought in PAGE with what its madvise() advice calls
+// for: for sequential access, reads the next pages in and lets old ones go
+void page_read_ahead(struct page *page) {
+  if (!page->sequential) {
+    return;
+  }
+  struct thread *cur = thread_current();
+  uint8_t *upage = page->vaddr;
+  for (int i = 1; i <= READ_AHEAD_PAGES; i++) {
+    struct page *next = spt_lookup(upage + i * PGSIZE, &cur->spt);
+    if (next == NULL || !next->sequential) {
+      break;
+    }
+    if (pagedir_get_page(cur->pagedir, next->vaddr) == NULL
+        && !page_load(next)) {
+      break;
+    }
+  }
+  if ((uintptr_t) upage >= READ_AHEAD_PAGES * PGSIZE) {
+    struct page *old = spt_lookup(upage - READ_AHEAD_PAGES * PGSIZE,
+                                  &cur->spt);
+    if (old != NULL && old->sequential) {
+      frame_deactivate(cur->pagedir, old->vaddr);
+    }
+  }
+}
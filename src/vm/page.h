@@ -3,16 +3,21 @@
 
 #include <debug.h>
 #include <hash.h>
+#include <list.h>
 #include "devices/swap.h"
 #include "vm/frame.h"
 #include "threads/thread.h"
+#include "threads/slab.h"
 #include "filesys/off_t.h"
 
 struct lock spt_lock;
+extern struct kmem_cache spt_cache; // Cache of struct page
 
 enum page_status {
     PAGE_FILE, // Page backed by a file
     PAGE_STACK, // Page allocated for stack
+    PAGE_ANON, // Zero-filled page, of the heap or an anonymous mapping
+    PAGE_SHARED, // Page of a file mapped with MAP_SHARED (see vm/share.c)
 };
 
 // Supplemental page table entry
@@ -28,13 +33,21 @@ struct page {
   int read_bytes; // read bytes(lazy load)
   int zero_bytes; // zero bytes(lazy load)
   off_t file_offset; // file offset(lazy load)
+  bool sequential; // MADV_SEQUENTIAL given: faults read ahead
+  struct shared_page *shared; // Shared file page, for PAGE_SHARED
+  struct thread *owner; // Process the page belongs to, for PAGE_SHARED
+  struct list_elem shared_elem; // Element in the shared page's mappers
 
   struct hash_elem hash_elem;
 };
 
+void spt_init(void);
 unsigned spt_hash(const struct hash_elem *p_hash_elem, void *aux UNUSED);
 bool spt_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED);
 void spt_free(struct hash_elem *e, void *aux UNUSED);
 struct page *spt_lookup(void *vaddr, struct hash *spt);
+void page_release(struct page *page, bool clear_pte);
+bool page_load(struct page *page);
+void page_read_ahead(struct page *page);
 
 #endif //PINTOS_47_PAGE_H
@@ -0,0 +1,238 @@
+#include "vm/share.h"
+#include <string.h>
+#include "filesys/inode.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+
+/* Shared file mappings.
+
+   Each page of a file that some process maps with MAP_SHARED has
+   one shared_page, found by inode and offset, which the SPT
+   entries of all the processes mapping it point to.  The page
+   has at most one frame, which is mapped into each process as it
+   touches the page, so that they all see each other's writes at
+   once.  Changes go back to the file when the frame is evicted,
+   when msync() asks for it, and when the last mapping goes.
+
+   share_lock serializes the processes that look up, bring in and
+   drop shared pages.  A shared page's frame, its dirty flag and
+   its list of mappers are also protected by frame_table_lock, so
+   that frame_evict() can use them while holding only that. */
+
+// Shared pages, by inode and offset
+static struct hash shared_pages;
+static struct lock share_lock;
+
+// Cache that shared_page structs come from
+static struct kmem_cache shared_cache;
+
+static unsigned shared_hash(const struct hash_elem *e, void *aux UNUSED) {
+  const struct shared_page *sp = hash_entry(e, struct shared_page, hash_elem);
+  return hash_bytes(&sp->inode, sizeof sp->inode) ^ hash_int(sp->offset);
+}
+
+static bool shared_less(const struct hash_elem *a_, const struct hash_elem *b_,
+                        void *aux UNUSED) {
+  const struct shared_page *a = hash_entry(a_, struct shared_page, hash_elem);
+  const struct shared_page *b = hash_entry(b_, struct shared_page, hash_elem);
+  return a->inode != b->inode ? a->inode < b->inode : a->offset < b->offset;
+}
+
+void share_init(void) {
+  hash_init(&shared_pages, shared_hash, shared_less, NULL);
+  lock_init(&share_lock);
+  kmem_cache_init(&shared_cache, "shared page", sizeof(struct shared_page),
+                  NULL);
+}
+
+/* Writes SP back to its file if it was changed through any mapping, and clears
+   the dirty bits that said so. SP must be in its frame, and frame_table_lock
+   must be held, since otherwise the frame could be evicted mid-write.
+
+   munmap and msync also hold filesystem_lock, as every other file write does.
+   Eviction cannot: it runs inside frame_alloc(), often in a thread that
+   already holds filesystem_lock, and under frame_table_lock, which comes after
+   filesystem_lock in the lock order. It is safe without it because the write
+   never grows the file, so it changes no inode or free map state, only the
+   data sectors, and the block device serializes those itself. The mapping
+   holds the file open, so the inode cannot go away meanwhile */
+static void write_back(struct shared_page *sp) {
+  bool dirty = sp->dirty;
+  for (struct list_elem *e = list_begin(&sp->mappers);
+       e != list_end(&sp->mappers); e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, shared_elem);
+    uint32_t *pd = page->owner->pagedir;
+    if (pagedir_get_page(pd, page->vaddr) != NULL
+        && pagedir_is_dirty(pd, page->vaddr)) {
+      pagedir_set_dirty(pd, page->vaddr, false);
+      dirty = true;
+    }
+  }
+  if (dirty) {
+    inode_write_at(sp->inode, sp->frame->frame_addr, sp->read_bytes,
+                   sp->offset);
+  }
+  sp->dirty = false;
+}
+
+/* Unmaps PAGE from its process, remembering whether it was written through
+   that mapping. Leaves the PTE to the caller if CLEAR_PTE is false.
+   frame_table_lock must be held */
+static void unmap(struct page *page, bool clear_pte) {
+  uint32_t *pd = page->owner->pagedir;
+  if (pagedir_get_page(pd, page->vaddr) != NULL) {
+    if (pagedir_is_dirty(pd, page->vaddr)) {
+      page->shared->dirty = true;
+    }
+    if (clear_pte) {
+      pagedir_clear_page(pd, page->vaddr);
+    }
+  }
+}
+
+/* Makes PAGE, a page of the running process, map the READ_BYTES bytes of
+   INODE at OFFSET, which must be page aligned, shared with any other process
+   that maps them. Returns false if memory runs out */
+bool share_attach(struct page *page, struct inode *inode, off_t offset,
+                  size_t read_bytes) {
+  ASSERT(offset % PGSIZE == 0);
+  struct shared_page key;
+  key.inode = inode;
+  key.offset = offset;
+
+  lock_acquire(&share_lock);
+  struct hash_elem *e = hash_find(&shared_pages, &key.hash_elem);
+  struct shared_page *sp;
+  if (e != NULL) {
+    sp = hash_entry(e, struct shared_page, hash_elem);
+  } else {
+    sp = kmem_cache_alloc(&shared_cache);
+    if (sp == NULL) {
+      lock_release(&share_lock);
+      return false;
+    }
+    sp->inode = inode;
+    sp->offset = offset;
+    sp->read_bytes = read_bytes;
+    sp->frame = NULL;
+    sp->dirty = false;
+    list_init(&sp->mappers);
+    hash_insert(&shared_pages, &sp->hash_elem);
+  }
+  page->status = PAGE_SHARED;
+  page->shared = sp;
+  page->owner = thread_current();
+  lock_acquire(&frame_table_lock);
+  list_push_back(&sp->mappers, &page->shared_elem);
+  lock_release(&frame_table_lock);
+  lock_release(&share_lock);
+  return true;
+}
+
+/* Removes PAGE, a shared page of the running process, from its process.
+   When it was the page's last mapping, writes the page back and frees it.
+   If CLEAR_PTE is false, the caller must clear PAGE's PTE before the process
+   runs again, as for page_release() */
+void share_detach(struct page *page, bool clear_pte) {
+  struct shared_page *sp = page->shared;
+  lock_acquire(&share_lock);
+  lock_acquire(&frame_table_lock);
+  unmap(page, clear_pte);
+  list_remove(&page->shared_elem);
+  bool last = list_empty(&sp->mappers);
+  if (last && sp->frame != NULL) {
+    write_back(sp);
+    frame_free_locked(sp->frame->frame_addr);
+    sp->frame = NULL;
+  }
+  lock_release(&frame_table_lock);
+  if (last) {
+    hash_delete(&shared_pages, &sp->hash_elem);
+    kmem_cache_free(&shared_cache, sp);
+  }
+  lock_release(&share_lock);
+  page->shared = NULL;
+}
+
+/* Maps shared PAGE into the running process, first reading it into a frame
+   if no process has it in one. Returns false if that fails */
+bool share_load(struct page *page) {
+  struct shared_page *sp = page->shared;
+  lock_acquire(&share_lock);
+  lock_acquire(&frame_table_lock);
+  if (sp->frame == NULL) {
+    lock_release(&frame_table_lock);
+    struct frame_entry *f = frame_alloc(PAL_USER, page->vaddr);
+    if (f == NULL) {
+      lock_release(&share_lock);
+      return false;
+    }
+    void *kaddr = f->frame_addr;
+    if (inode_read_at(sp->inode, kaddr, sp->read_bytes, sp->offset)
+        != (off_t) sp->read_bytes) {
+      frame_free(kaddr);
+      lock_release(&share_lock);
+      return false;
+    }
+    memset(kaddr + sp->read_bytes, 0, PGSIZE - sp->read_bytes);
+    lock_acquire(&frame_table_lock);
+    f->shared = sp;
+    sp->frame = f;
+  }
+  bool success = pagedir_set_page(page->owner->pagedir, page->vaddr,
+                                  sp->frame->frame_addr, page->writable);
+  lock_release(&frame_table_lock);
+  lock_release(&share_lock);
+  return success;
+}
+
+/* Unmaps shared PAGE from the running process, which no longer needs it, but
+   leaves it in the process's address space. Once no process has it mapped,
+   its frame is the next to be evicted */
+void share_release(struct page *page) {
+  lock_acquire(&frame_table_lock);
+  unmap(page, true);
+  lock_release(&frame_table_lock);
+}
+
+/* Writes shared PAGE back to its file if it is in a frame and has been changed.
+   filesystem_lock must be held */
+void share_sync(struct page *page) {
+  lock_acquire(&frame_table_lock);
+  if (page->shared->frame != NULL) {
+    write_back(page->shared);
+  }
+  lock_release(&frame_table_lock);
+}
+
+/* Returns true if any process has accessed SP since the last call, and clears
+   the accessed bits that say so. frame_table_lock must be held */
+bool share_accessed(struct shared_page *sp) {
+  bool accessed = false;
+  for (struct list_elem *e = list_begin(&sp->mappers);
+       e != list_end(&sp->mappers); e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, shared_elem);
+    uint32_t *pd = page->owner->pagedir;
+    if (pagedir_is_accessed(pd, page->vaddr)) {
+      pagedir_set_accessed(pd, page->vaddr, false);
+      accessed = true;
+    }
+  }
+  return accessed;
+}
+
+/* Takes SP out of its frame, unmapping it from every process and writing it
+   back if it has changed. The frame is left in the frame table for the
+   caller. frame_table_lock must be held */
+void share_evict(struct shared_page *sp) {
+  for (struct list_elem *e = list_begin(&sp->mappers);
+       e != list_end(&sp->mappers); e = list_next(e)) {
+    unmap(list_entry(e, struct page, shared_elem), true);
+  }
+  write_back(sp);
+  sp->frame->shared = NULL;
+  sp->frame = NULL;
+}
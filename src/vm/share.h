@@ -0,0 +1,35 @@
+#ifndef VM_SHARE_H
+#define VM_SHARE_H
+
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include "filesys/off_t.h"
+#include "vm/frame.h"
+
+struct inode;
+struct page;
+
+// A page of a file mapped with MAP_SHARED. Every process that maps it sees it
+// through the same frame
+struct shared_page {
+  struct inode *inode;          // File the page belongs to
+  off_t offset;                 // Offset of the page in the file
+  size_t read_bytes;            // Bytes of the page that lie within the file
+  struct frame_entry *frame;    // Frame holding the page, or null
+  bool dirty;                   // Written through a mapping since removed
+  struct list mappers;          // PAGE_SHARED pages that map it
+  struct hash_elem hash_elem;   // Element in the shared page table
+};
+
+void share_init(void);
+bool share_attach(struct page *page, struct inode *inode, off_t offset,
+                  size_t read_bytes);
+void share_detach(struct page *page, bool clear_pte);
+bool share_load(struct page *page);
+void share_release(struct page *page);
+void share_sync(struct page *page);
+bool share_accessed(struct shared_page *sp);
+void share_evict(struct shared_page *sp);
+
+#endif